@@ -16,6 +16,78 @@
 #include <stdio.h>      // Required for: printf()
 #include <math.h>       // Required for: colors image generation
 
+// Memory buffer filled by PNG data writing callback
+typedef struct {
+    char *data;
+    int size;
+} test_buffer;
+
+// PNG data writing callback: data pieces are appended to memory buffer (provided as user data)
+static bool test_buffer_write(void *user_data, const char *data, int size)
+{
+    test_buffer *buffer = (test_buffer *)user_data;
+    char *buffer_data = (char *)RPNG_REALLOC(buffer->data, buffer->size + size);
+
+    if (buffer_data != NULL)
+    {
+        memcpy(buffer_data + buffer->size, data, size);
+        buffer->data = buffer_data;
+        buffer->size += size;
+    }
+
+    return (buffer_data != NULL);
+}
+
+// Stored blocks codec: compressed data size bound, zlib header + stored blocks (5 bytes header per 64KB) + adler32
+static int test_codec_bound(void *user_data, int size)
+{
+    (void)user_data;
+
+    return 2 + 5*(size/65535 + 1) + size + 4;
+}
+
+// Stored blocks codec: zlib stream with data stored uncompressed, compression fails if requested (user data flag)
+static int test_codec_compress(void *user_data, char *output, int output_capacity, const char *data, int size, int level)
+{
+    (void)level;
+    unsigned char *out = (unsigned char *)output;
+    unsigned int a = 1, b = 0;
+    int out_size = 0;
+
+    if (*(bool *)user_data || (output_capacity < test_codec_bound(NULL, size))) return 0;
+
+    out[out_size++] = 0x78;     // Zlib header: deflate, 32KB window
+    out[out_size++] = 0x01;
+
+    for (int offset = 0; (offset < size) || (offset == 0); offset += 65535)
+    {
+        int length = ((size - offset) < 65535)? (size - offset) : 65535;
+
+        out[out_size++] = ((offset + length) >= size)? 1 : 0;   // Stored block, final if last one
+        out[out_size++] = (unsigned char)(length & 0xff);
+        out[out_size++] = (unsigned char)(length >> 8);
+        out[out_size++] = (unsigned char)(~length & 0xff);
+        out[out_size++] = (unsigned char)((~length >> 8) & 0xff);
+        memcpy(out + out_size, data + offset, length);
+        out_size += length;
+
+        if (size == 0) break;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        a = (a + (unsigned char)data[i])%65521;
+        b = (b + a)%65521;
+    }
+
+    out[out_size++] = (unsigned char)(b >> 8);
+    out[out_size++] = (unsigned char)(b & 0xff);
+    out[out_size++] = (unsigned char)(a >> 8);
+    out[out_size++] = (unsigned char)(a & 0xff);
+
+    return out_size;
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -203,6 +275,500 @@ int main(int argc, char *argv[])
         //rpng_save_image_indexed("resources/scarfy_indexed_output.png", width, height, palette, palette_alpha, palette_size);
     }
 #endif
+#if 1
+    // TEST: Noise-like data compression at default level
+    // Matches search is skipped on noise-like data at default level, level 9 always searches,
+    // default level output must not be bigger than level 9 output by more than a small margin
+    // and data must still be compressed under a size ratio (percentage of raw data size)
+    {
+        const char *test_names[3] = { "tiled noise", "LCG noise", "half noise, half gradient" };
+        const int test_ratios[3] = { 55, 80, 45 };
+        int test_width = 1024;
+        int test_height = 512;
+        char *test_data = RPNG_MALLOC(test_width*test_height*3);
+        unsigned int seed = 12345;
+
+        for (int test = 0; test < 3; test++)
+        {
+            for (int y = 0; y < test_height; y++)
+            {
+                for (int x = 0; x < test_width*3; x++)
+                {
+                    seed = seed*1103515245 + 12345;
+
+                    // Tiled noise: 512 pixels wide noise tile repeated along rows
+                    if ((test == 0) && (x >= 512*3)) test_data[y*test_width*3 + x] = test_data[y*test_width*3 + x - 512*3];
+                    else if ((test == 2) && (y >= test_height/2)) test_data[y*test_width*3 + x] = (char)(x/3 + y);
+                    else test_data[y*test_width*3 + x] = (char)((seed >> 8) & 0xff);
+                }
+            }
+
+            rpng_save_options options = { 0 };
+            int default_size = 0;
+            int optimal_size = 0;
+            char *default_png = rpng_save_image_with_options_to_memory(test_data, test_width, test_height, 3, 8, options, &default_size);
+            options.compression_level = 9;
+            char *optimal_png = rpng_save_image_with_options_to_memory(test_data, test_width, test_height, 3, 8, options, &optimal_size);
+
+            bool passed = (default_png != NULL) && (optimal_png != NULL) && (default_size <= optimal_size + optimal_size/50) &&
+                          (default_size <= (int)((long long)test_width*test_height*3*test_ratios[test]/100));
+            printf("Compression %s: default level %i bytes, level 9 %i bytes: %s\n", test_names[test], default_size, optimal_size, passed? "PASSED" : "FAILED");
+
+            RPNG_FREE(default_png);
+            RPNG_FREE(optimal_png);
+        }
+
+        RPNG_FREE(test_data);
+    }
+#endif
 
+#if 1
+    // TEST: Interlaced (Adam7) image data saving and loading
+    // Images are saved interlaced at every pixel size (1/2/3/4/6/8 bytes), including sizes with empty passes,
+    // loaded image data must match saved image data
+    {
+        const int test_formats[6][2] = { { 1, 8 }, { 2, 8 }, { 3, 8 }, { 4, 8 }, { 3, 16 }, { 4, 16 } };   // Color channels, bit depth
+        const int test_sizes[5][2] = { { 1, 1 }, { 2, 3 }, { 7, 7 }, { 9, 17 }, { 61, 33 } };
+        unsigned int seed = 12345;
+
+        for (int format = 0; format < 6; format++)
+        {
+            int test_channels = test_formats[format][0];
+            int test_bit_depth = test_formats[format][1];
+            bool passed = true;
+
+            for (int size = 0; size < 5; size++)
+            {
+                int test_width = test_sizes[size][0];
+                int test_height = test_sizes[size][1];
+                int test_data_size = test_width*test_height*test_channels*test_bit_depth/8;
+                char *test_data = RPNG_MALLOC(test_data_size);
+
+                for (int i = 0; i < test_data_size; i++)
+                {
+                    seed = seed*1103515245 + 12345;
+                    test_data[i] = (char)(seed >> 24);
+                }
+
+                rpng_save_options options = { 0 };
+                options.interlace = true;
+                options.reduce_color_type = RPNG_REDUCE_DISABLED;
+                int png_size = 0;
+                char *png_data = rpng_save_image_with_options_to_memory(test_data, test_width, test_height, test_channels, test_bit_depth, options, &png_size);
+
+                int load_width = 0;
+                int load_height = 0;
+                int load_channels = 0;
+                int load_bit_depth = 0;
+                char *load_data = rpng_load_image_from_memory(png_data, &load_width, &load_height, &load_channels, &load_bit_depth);
+
+                if ((load_data == NULL) || (load_width != test_width) || (load_height != test_height) || (load_channels != test_channels) ||
+                    (load_bit_depth != test_bit_depth) || (memcmp(load_data, test_data, test_data_size) != 0)) passed = false;
+
+                RPNG_FREE(load_data);
+                RPNG_FREE(png_data);
+                RPNG_FREE(test_data);
+            }
+
+            printf("Interlaced image data, pixel size %i: %s\n", test_channels*test_bit_depth/8, passed? "PASSED" : "FAILED");
+        }
+    }
+#endif
+
+#if 1
+    // TEST: Sub-byte (1/2/4 bit) image data packing and unpacking
+    // Indexed data with palettes of 2/4/16 colors is saved packed and loaded back as 8 bit indexes,
+    // same packed data is loaded as 1/2/4 bit grayscale (color type patched, PLTE removed) scaled to 8 bit
+    // NOTE: Odd widths are used so last scanline byte is only partially filled
+    {
+        const int test_colors[3] = { 2, 4, 16 };
+        const int test_widths[4] = { 1, 3, 13, 37 };
+        int test_height = 5;
+        rpng_color test_palette_colors[16] = { 0 };
+        unsigned int seed = 12345;
+
+        for (int i = 0; i < 16; i++) test_palette_colors[i] = (rpng_color){ (unsigned char)(i*16), (unsigned char)(255 - i*16), (unsigned char)(i*7), 255 };
+
+        for (int colors = 0; colors < 3; colors++)
+        {
+            rpng_palette test_palette = { test_colors[colors], test_palette_colors };
+            int pack_depth = (test_colors[colors] == 2)? 1 : (test_colors[colors] == 4)? 2 : 4;
+            bool indexed_passed = true;
+            bool gray_passed = true;
+
+            for (int size = 0; size < 4; size++)
+            {
+                int test_width = test_widths[size];
+                char *test_data = RPNG_MALLOC(test_width*test_height);
+
+                for (int i = 0; i < test_width*test_height; i++)
+                {
+                    seed = seed*1103515245 + 12345;
+                    test_data[i] = (char)((seed >> 16)%test_colors[colors]);
+                }
+
+                int png_size = 0;
+                char *png_data = rpng_save_image_indexed_to_memory(test_data, test_width, test_height, test_palette, &png_size);
+
+                // Indexed data unpacked to 8 bit indexes
+                int load_width = 0;
+                int load_height = 0;
+                rpng_palette load_palette = { 0 };
+                char *load_data = rpng_load_image_indexed_from_memory(png_data, &load_width, &load_height, &load_palette);
+
+                if ((load_data == NULL) || (load_width != test_width) || (load_height != test_height) ||
+                    (load_palette.color_count != test_colors[colors]) || (memcmp(load_data, test_data, test_width*test_height) != 0)) indexed_passed = false;
+
+                RPNG_FREE(load_data);
+                RPNG_FREE(load_palette.colors);
+
+                // Packed indexes loaded as grayscale: IHDR color type set to 0 (CRC updated), PLTE chunk removed
+                int gray_png_size = 0;
+                char *gray_png_data = rpng_chunk_remove_from_memory(png_data, "PLTE", &gray_png_size);
+
+                if (gray_png_data != NULL)
+                {
+                    gray_png_data[8 + 8 + 9] = 0;
+                    unsigned int crc = swap_endian(compute_crc32((unsigned char *)gray_png_data + 8 + 4, 4 + 13));
+                    memcpy(gray_png_data + 8 + 8 + 13, &crc, 4);
+                }
+
+                int load_channels = 0;
+                int load_bit_depth = 0;
+                load_data = rpng_load_image_from_memory(gray_png_data, &load_width, &load_height, &load_channels, &load_bit_depth);
+
+                if ((load_data == NULL) || (load_channels != 1) || (load_bit_depth != 8)) gray_passed = false;
+                else
+                {
+                    for (int i = 0; i < test_width*test_height; i++)
+                    {
+                        if ((unsigned char)load_data[i] != test_data[i]*(255/((1 << pack_depth) - 1))) gray_passed = false;
+                    }
+                }
+
+                RPNG_FREE(load_data);
+                RPNG_FREE(gray_png_data);
+                RPNG_FREE(png_data);
+                RPNG_FREE(test_data);
+            }
+
+            printf("Packed image data, %i bit indexed: %s\n", pack_depth, indexed_passed? "PASSED" : "FAILED");
+            printf("Packed image data, %i bit grayscale: %s\n", pack_depth, gray_passed? "PASSED" : "FAILED");
+        }
+    }
+#endif
+#if 1
+    // TEST: Image data loading with output format conversion
+    // Every pixel format (8/16 bit gray, gray+alpha, RGB, RGBA and indexed with tRNS) is loaded with every
+    // RPNG_OUTPUT_* flags combination, loaded data must match a reference conversion computed pixel by pixel
+    // NOTE: Image width covers SIMD kernels (SSE2 conversions, AVX2 palette expansion) and their scalar tails
+    {
+        const char *test_names[9] = { "8 bit gray", "8 bit gray+alpha", "8 bit RGB", "8 bit RGBA", "16 bit gray", "16 bit gray+alpha", "16 bit RGB", "16 bit RGBA", "indexed+tRNS" };
+        const int test_formats[9][2] = { { 1, 8 }, { 2, 8 }, { 3, 8 }, { 4, 8 }, { 1, 16 }, { 2, 16 }, { 3, 16 }, { 4, 16 }, { 1, 8 } };   // Color channels, bit depth
+        const int test_orders[6][4] = { { 0 }, { 0 }, { 0, 3 }, { 0, 1, 2 }, { 0, 1, 2, 3 }, { 2, 1, 0, 3 } };   // Output channels values order (RGBA values), last one BGRA
+        int test_width = 37;
+        int test_height = 3;
+        rpng_color test_palette_colors[200] = { 0 };
+        unsigned int seed = 12345;
+
+        for (int i = 0; i < 200; i++)
+        {
+            seed = seed*1103515245 + 12345;
+            test_palette_colors[i] = (rpng_color){ (unsigned char)(seed >> 24), (unsigned char)(seed >> 16), (unsigned char)(seed >> 8), (unsigned char)((i < 100)? (seed >> 20) : 255) };
+        }
+
+        rpng_palette test_palette = { 200, test_palette_colors };
+
+        for (int format = 0; format < 9; format++)
+        {
+            bool indexed = (format == 8);
+            int test_channels = test_formats[format][0];
+            int test_bit_depth = test_formats[format][1];
+            int test_pixel_size = test_channels*test_bit_depth/8;
+            char *test_data = RPNG_MALLOC(test_width*test_height*test_pixel_size);
+
+            for (int i = 0; i < test_width*test_height*test_pixel_size; i++)
+            {
+                seed = seed*1103515245 + 12345;
+                test_data[i] = (char)(indexed? (seed >> 16)%200 : (seed >> 24));
+            }
+
+            rpng_save_options options = { 0 };
+            options.reduce_color_type = RPNG_REDUCE_DISABLED;
+            int png_size = 0;
+            char *png_data = indexed? rpng_save_image_indexed_to_memory(test_data, test_width, test_height, test_palette, &png_size) :
+                rpng_save_image_with_options_to_memory(test_data, test_width, test_height, test_channels, test_bit_depth, options, &png_size);
+
+            bool passed = (png_data != NULL);
+
+            for (int output_format = 0; (output_format < 32) && passed; output_format++)
+            {
+                int load_width = 0;
+                int load_height = 0;
+                int load_channels = 0;
+                int load_bit_depth = 0;
+                unsigned char *load_data = (unsigned char *)rpng_load_image_with_format_from_memory(png_data, &load_width, &load_height, &load_channels, &load_bit_depth, output_format);
+
+                // Reference conversion: pixel values read as RGBA (16 bit range for 16 bit data), converted and stored in output order
+                bool expand = (output_format & (RPNG_OUTPUT_RGBA | RPNG_OUTPUT_BGRA)) != 0;
+                bool alpha = indexed || (test_channels == 2) || (test_channels == 4);
+                bool wide = (test_bit_depth == 16);
+                bool output_wide = wide && !(output_format & RPNG_OUTPUT_8BIT);
+                unsigned int max = wide? 65535 : 255;
+                int output_channels = expand? 4 : test_channels;
+                int output_pixel_size = output_channels*(output_wide? 2 : 1);
+                const int *order = test_orders[(output_format & RPNG_OUTPUT_BGRA)? 5 : output_channels];
+
+                if ((load_data == NULL) || (load_channels != output_channels) || (load_bit_depth != (output_wide? 16 : 8))) passed = false;
+                else if (indexed && !expand) passed = (memcmp(load_data, test_data, test_width*test_height) == 0);
+                else
+                {
+                    for (int i = 0; i < test_width*test_height; i++)
+                    {
+                        const unsigned char *pixel = (const unsigned char *)test_data + i*test_pixel_size;
+                        unsigned int value[4] = { 0, 0, 0, max };
+
+                        if (indexed)
+                        {
+                            rpng_color color = test_palette_colors[pixel[0]];
+                            value[0] = color.r; value[1] = color.g; value[2] = color.b; value[3] = color.a;
+                        }
+                        else
+                        {
+                            for (int c = 0; c < test_channels; c++) value[c] = wide? ((pixel[c*2] << 8) | pixel[c*2 + 1]) : pixel[c];
+                            if (test_channels <= 2)
+                            {
+                                if (alpha) value[3] = value[1];
+                                value[1] = value[2] = value[0];
+                            }
+                        }
+
+                        if ((output_format & RPNG_OUTPUT_PREMULTIPLY) && alpha)
+                        {
+                            for (int c = 0; c < 3; c++) value[c] = (unsigned int)(((unsigned long long)value[c]*value[3] + max/2)/max);
+                        }
+
+                        if (wide && !output_wide) for (int c = 0; c < 4; c++) value[c] = (value[c] + 128)/257;
+
+                        for (int c = 0; c < output_channels; c++)
+                        {
+                            const unsigned char *output = load_data + i*output_pixel_size + c*(output_wide? 2 : 1);
+                            unsigned int v = value[order[c]];
+                            unsigned int output_value = output[0];
+
+                            if (output_wide && (output_format & RPNG_OUTPUT_HOST_ENDIAN))
+                            {
+                                unsigned short host_value = 0;
+                                memcpy(&host_value, output, 2);
+                                output_value = host_value;
+                            }
+                            else if (output_wide) output_value = (output[0] << 8) | output[1];
+
+                            if (output_value != v) passed = false;
+                        }
+                    }
+                }
+
+                RPNG_FREE(load_data);
+            }
+
+            printf("Output format conversion, %s: %s\n", test_names[format], passed? "PASSED" : "FAILED");
+
+            RPNG_FREE(png_data);
+            RPNG_FREE(test_data);
+        }
+    }
+#endif
+#if 1
+    // TEST: Image data region loading
+    // Regions touching image edges are loaded from non-interlaced and interlaced images,
+    // region data must match same region cropped from full image data
+    {
+        int test_width = 37;
+        int test_height = 29;
+        const int test_regions[9][4] = {
+            { 0, 0, 37, 29 }, { 0, 0, 1, 1 }, { 36, 28, 1, 1 }, { 0, 28, 37, 1 }, { 32, 0, 5, 29 },
+            { 3, 2, 10, 7 }, { 30, 23, 7, 6 }, { 1, 1, 35, 27 }, { 5, 27, 9, 2 } };  // x, y, width, height
+        char *test_data = RPNG_MALLOC(test_width*test_height*3);
+        unsigned int seed = 12345;
+
+        for (int i = 0; i < test_width*test_height*3; i++)
+        {
+            seed = seed*1103515245 + 12345;
+            test_data[i] = (char)(seed >> 24);
+        }
+
+        for (int interlace = 0; interlace < 2; interlace++)
+        {
+            rpng_save_options options = { 0 };
+            options.interlace = (interlace == 1);
+            options.reduce_color_type = RPNG_REDUCE_DISABLED;
+            int png_size = 0;
+            char *png_data = rpng_save_image_with_options_to_memory(test_data, test_width, test_height, 3, 8, options, &png_size);
+
+            int load_width = 0;
+            int load_height = 0;
+            int load_channels = 0;
+            int load_bit_depth = 0;
+            char *load_data = rpng_load_image_from_memory(png_data, &load_width, &load_height, &load_channels, &load_bit_depth);
+            bool passed = (load_data != NULL);
+
+            for (int region = 0; (region < 9) && passed; region++)
+            {
+                int x = test_regions[region][0];
+                int y = test_regions[region][1];
+                int region_width = test_regions[region][2];
+                int region_height = test_regions[region][3];
+                char *region_data = rpng_load_image_region_from_memory(png_data, x, y, region_width, region_height, &load_channels, &load_bit_depth);
+
+                if ((region_data == NULL) || (load_channels != 3) || (load_bit_depth != 8)) passed = false;
+                else
+                {
+                    for (int row = 0; row < region_height; row++)
+                    {
+                        if (memcmp(region_data + row*region_width*3, load_data + ((y + row)*test_width + x)*3, region_width*3) != 0) passed = false;
+                    }
+                }
+
+                RPNG_FREE(region_data);
+            }
+
+            printf("Image data region, %s: %s\n", interlace? "interlaced" : "non-interlaced", passed? "PASSED" : "FAILED");
+
+            RPNG_FREE(load_data);
+            RPNG_FREE(png_data);
+        }
+
+        RPNG_FREE(test_data);
+    }
+#endif
+#if 1
+    // TEST: Image saving by rows (encoder)
+    // Image rows are pushed to encoder in batches of different sizes, PNG data written to callback
+    // must be loaded as the same image data than PNG data saved at once
+    {
+        const int test_formats[2][4] = { { 300, 200, 4, 8 }, { 61, 33, 3, 16 } };   // Width, height, color channels, bit depth
+        unsigned int seed = 12345;
+
+        for (int format = 0; format < 2; format++)
+        {
+            int test_width = test_formats[format][0];
+            int test_height = test_formats[format][1];
+            int test_channels = test_formats[format][2];
+            int test_bit_depth = test_formats[format][3];
+            int test_row_size = test_width*test_channels*test_bit_depth/8;
+            char *test_data = RPNG_MALLOC(test_row_size*test_height);
+
+            // Gradient with some noise, big enough to be written as multiple IDAT chunks
+            for (int i = 0; i < test_row_size*test_height; i++)
+            {
+                seed = seed*1103515245 + 12345;
+                test_data[i] = (char)(i/test_row_size + (i%test_row_size)/7 + ((seed >> 24) & 0x0f));
+            }
+
+            test_buffer buffer = { 0 };
+            rpng_encoder *encoder = rpng_encoder_begin(test_width, test_height, test_channels, test_bit_depth, test_buffer_write, &buffer);
+            bool passed = (encoder != NULL);
+
+            if (encoder != NULL)
+            {
+                passed = rpng_encoder_push_rows(encoder, test_data, 1) &&
+                         rpng_encoder_push_rows(encoder, test_data + test_row_size, 7) &&
+                         rpng_encoder_push_rows(encoder, test_data + test_row_size*8, test_height - 8);
+                passed = rpng_encoder_end(encoder) && passed;
+            }
+
+            int png_size = 0;
+            char *png_data = rpng_save_image_to_memory(test_data, test_width, test_height, test_channels, test_bit_depth, &png_size);
+
+            int load_width = 0;
+            int load_height = 0;
+            int load_channels = 0;
+            int load_bit_depth = 0;
+            char *load_data = rpng_load_image_from_memory(png_data, &load_width, &load_height, &load_channels, &load_bit_depth);
+            char *encoder_data = passed? rpng_load_image_from_memory(buffer.data, &load_width, &load_height, &load_channels, &load_bit_depth) : NULL;
+
+            if ((load_data == NULL) || (encoder_data == NULL) || (load_width != test_width) || (load_height != test_height) ||
+                (load_channels != test_channels) || (load_bit_depth != test_bit_depth) ||
+                (memcmp(encoder_data, load_data, test_row_size*test_height) != 0) ||
+                (memcmp(encoder_data, test_data, test_row_size*test_height) != 0)) passed = false;
+
+            printf("Image saving by rows, %i bit %i channels: %s\n", test_bit_depth, test_channels, passed? "PASSED" : "FAILED");
+
+            RPNG_FREE(encoder_data);
+            RPNG_FREE(load_data);
+            RPNG_FREE(png_data);
+            RPNG_FREE(buffer.data);
+            RPNG_FREE(test_data);
+        }
+    }
+#endif
+#if 1
+    // TEST: Custom compression codec
+    // Image data and compressed text are compressed by a stored blocks codec, loaded by internal decompressor,
+    // on codec compression failure no image data (IDAT) or compressed text (zTXt) must be written
+    {
+        int test_width = 61;
+        int test_height = 33;
+        char *test_data = RPNG_MALLOC(test_width*test_height*3);
+        const char *test_filename = "resources/codec_rpng.png";
+        bool codec_failure = false;
+        rpng_codec codec = { 0 };
+        codec.user_data = &codec_failure;
+        codec.compress_bound = test_codec_bound;
+        codec.compress = test_codec_compress;
+
+        for (int i = 0; i < test_width*test_height*3; i++) test_data[i] = (char)(i*7);
+
+        rpng_save_image(test_filename, test_data, test_width, test_height, 3, 8);
+        int test_chunk_count = rpng_chunk_count(test_filename);
+
+        rpng_set_codec(&codec);
+
+        // Codec compression succeeds: image data and compressed text are written
+        int png_size = 0;
+        char *png_data = rpng_save_image_to_memory(test_data, test_width, test_height, 3, 8, &png_size);
+
+        int load_width = 0;
+        int load_height = 0;
+        int load_channels = 0;
+        int load_bit_depth = 0;
+        char *load_data = rpng_load_image_from_memory(png_data, &load_width, &load_height, &load_channels, &load_bit_depth);
+        bool passed = (load_data != NULL) && (memcmp(load_data, test_data, test_width*test_height*3) == 0);
+        RPNG_FREE(load_data);
+        RPNG_FREE(png_data);
+
+        rpng_chunk_write_comp_text(test_filename, "Comment", "rpng, compressed text written by custom codec");
+        rpng_chunk text_chunk = rpng_chunk_read(test_filename, "zTXt");
+        if ((rpng_chunk_count(test_filename) != (test_chunk_count + 1)) || !rpng_chunk_check_all_valid(test_filename) || (text_chunk.data == NULL)) passed = false;
+        RPNG_FREE(text_chunk.data);
+
+        printf("Custom codec compression: %s\n", passed? "PASSED" : "FAILED");
+
+        // Codec compression fails: no image data and no compressed text are written
+        rpng_save_image(test_filename, test_data, test_width, test_height, 3, 8);
+        codec_failure = true;
+        png_data = rpng_save_image_to_memory(test_data, test_width, test_height, 3, 8, &png_size);
+        passed = (png_data == NULL);
+        RPNG_FREE(png_data);
+
+        test_buffer buffer = { 0 };
+        rpng_encoder *encoder = rpng_encoder_begin(test_width, test_height, 3, 8, test_buffer_write, &buffer);
+        if ((encoder == NULL) || !rpng_encoder_push_rows(encoder, test_data, test_height) || rpng_encoder_end(encoder)) passed = false;
+        for (int i = 0; i + 4 <= buffer.size; i++) if (memcmp(buffer.data + i, "IDAT", 4) == 0) passed = false;
+        RPNG_FREE(buffer.data);
+
+        rpng_chunk_write_comp_text(test_filename, "Comment", "rpng, compressed text not written");
+        text_chunk = rpng_chunk_read(test_filename, "zTXt");
+        if ((rpng_chunk_count(test_filename) != test_chunk_count) || (text_chunk.data != NULL)) passed = false;
+        RPNG_FREE(text_chunk.data);
+
+        printf("Custom codec compression failure: %s\n", passed? "PASSED" : "FAILED");
+
+        rpng_set_codec(NULL);
+        remove(test_filename);
+        RPNG_FREE(test_data);
+    }
+#endif
     return 0;
 }
\ No newline at end of file
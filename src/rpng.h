@@ -1,6 +1,6 @@
 /**********************************************************************************************
 *
-*   rpng v1.5 - A simple and easy-to-use library to manage png chunks
+*   rpng v1.6 - A simple and easy-to-use library to manage png chunks
 *
 *   FEATURES:
 *       - Load/Save images from/to raw image data
@@ -11,7 +11,9 @@
 *       - Add custom chunks
 *
 *   LIMITATIONS:
-*       - Bit depths of 1/2/4 bits per pixel not supported, only 8/16 bits
+*       - Bit depths of 1/2/4 bits per pixel are loaded as 8 bit (grayscale values scaled, indexes kept)
+*       - Bit depths of 1/2/4 bits per pixel only saved for indexed data (palettes up to 16 colors)
+*       - Interlaced images (Adam7) can not be loaded by rows, full image data is required
 *
 *   POSSIBLE IMPROVEMENTS:
 *       - Support APNG chunks, added to PNG specs recently (draft)
@@ -31,6 +33,19 @@
 *       #define RPNG_NO_STDIO_WARNING
 *           Skips issuing a compiler warning when RPNG_NO_STDIO is defined.
 *
+*       #define RPNG_NO_SIMD
+*           Do not use SIMD intrinsics (SSE2, AVX2) on image data conversion, portable C code is used instead
+*
+*       #define RPNG_REDUCE_COLOR_TYPE
+*           Reduce color type by default on image saving (if not requested in saving options): image data is analyzed
+*           and written with the smallest lossless color type: alpha removed if opaque, gray if R == G == B,
+*           8 bit if 16 bit values are 8 bit scaled, indexed if 256 or less colors.
+*           NOTE: Loaded image format could differ from saved one, streaming encoder (rpng_encoder) does not reduce data
+*
+*       OpenMP (compiler flag: -fopenmp, /openmp)
+*           If the library is compiled with OpenMP enabled, some processes that can be done
+*           independently (i.e. chunks CRC validation, images batch loading/saving) are distributed between multiple threads
+*
 *   DEPENDENCIES: libc (C standard library)
 *       stdlib.h        Required for: malloc(), calloc(), free()
 *       string.h        Required for: memcmp(), memcpy()
@@ -90,6 +105,41 @@
 *       Comment          Miscellaneous comment; conversion from GIF comment
 *
 *   VERSIONS HISTORY:
+*       1.6 (16-Oct-2026) ADDED: rpng_chunk_find_invalid() (+ memory version)
+*                         ADDED: rpng_chunk_check_all_valid_from_memory()
+*                         REVIEWED: rpng_chunk_check_all_valid(), CRC computed in place, no chunks copy
+*                         ADDED: rpng_verify() (+ memory version), decode image data without storing it
+*                         ADDED: rpng_chunk_*_to_buffer(), chunks management into provided buffer
+*                         REVIEWED: Chunks management memory functions, exact output size allocated
+*                         ADDED: rpng_load_image_rows() (+ memory version), load image data row by row
+*                         REVIEWED: Image data decoded by scanlines into exact size output, RPNG_MAX_OUTPUT_SIZE removed
+*                         REVIEWED: Sizes computed as size_t checking overflows, support files bigger than 2GB
+*                         ADDED: rpng_load_images_batch() (+ memory version), load multiple images concurrently
+*                         ADDED: rpng_save_images_batch() (+ memory/callback versions), save multiple images concurrently
+*                         ADDED: rpng_encoder_begin()/rpng_encoder_push_rows()/rpng_encoder_end(), save image by rows
+*                         REVIEWED: Scanline filter selection heuristic, filters sums computed per scanline
+*                         ADDED: rpng_save_image_to_buffer() (+ indexed version) and rpng_save_bound()
+*                         REVIEWED: Image saving, PNG data generated by pieces, compressed data never copied
+*                         ADDED: rpng_save_options.reduce_color_type, save image data with smallest lossless color type
+*                         ADDED: Support bit depths 1/2/4 loading (unpacked to 8 bit) and indexed saving (palettes up to 16 colors)
+*                         ADDED: Support Adam7 interlaced images loading
+*                         ADDED: rpng_load_image_progressive() (+ memory version), image data provided after every pass
+*                         ADDED: rpng_save_image_with_options() (+ memory version), compression level and Adam7 interlacing
+*                         ADDED: rpng_load_image_with_format() (+ memory version), output format conversion while decoding
+*                         ADDED: Indexed image data expanded to RGBA/BGRA while decoding, palette colors lookup table
+*                         FIXED: rpng_unindex_image_data(), indexes bigger than 127 and out of palette range
+*                         ADDED: rpng_load_image_region() (+ memory version), decoding stopped after last region scanline
+*                         REVIEWED: sdefl, matches extended 8 bytes at a time, 64-bit bits buffer written by words
+*                         ADDED: sdefl fixed huffman blocks, blocks split when symbols statistics change
+*                         ADDED: rpng_save_options.strategy, fast RLE and Huffman only compression strategies
+*                         ADDED: Compression level 9, sdefl near-optimal parsing with iterated symbols costs
+*                         ADDED: rpng_save_options.memory_profile, sdefl state allocated at runtime and sized to data
+*                         ADDED: rpng_save_options.stats, sdefl matches search skipped on noise-like data blocks
+*                         REVIEWED: sinfl, literal pairs decoded per table entry, fast decoding loop without bounds checks
+*                         REVIEWED: sinfl, small offsets matches copied by pattern replication, AVX2 wide copies
+*                         REVIEWED: sinfl, input never read past its end, image data decompressed without padding copies
+*                         ADDED: rpng_set_codec(), pluggable compression codec, internal sdefl/sinfl by default
+*
 *       1.5 (28-Aug-2024) ADDED: Support indexed data loading and saving (PLTE, tRNS)
 *                         ADDED: rpng_load_image_indexed() (+ memory version)
 *                         ADDED: rpng_save_image_indexed() (+ memory version)
@@ -132,7 +182,7 @@
 #ifndef RPNG_H
 #define RPNG_H
 
-#define RPNG_VERSION    "1.5"
+#define RPNG_VERSION    "1.6"
 
 // Function specifiers in case library is build/used as a shared library (Windows)
 // NOTE: Microsoft specifiers to tell compiler that symbols are imported/exported from a .dll
@@ -179,10 +229,15 @@
     // Maximum number of chunks to read
     #define RPNG_MAX_CHUNKS_COUNT   64
 #endif
-#ifndef RPNG_MAX_OUTPUT_SIZE
-    // Maximum size for temporal buffer on write/remove chunks,
-    // buffer is scaled to required output file size before being returned
-    #define RPNG_MAX_OUTPUT_SIZE    (64*1024*1024)
+
+#ifndef RPNG_PARALLEL_MIN_SIZE
+    // Minimum data size to distribute work between multiple threads (only if OpenMP enabled)
+    #define RPNG_PARALLEL_MIN_SIZE  (1024*1024)
+#endif
+
+#ifndef RPNG_IDAT_CHUNK_SIZE
+    // IDAT chunks data size on image saving by rows (streaming encoder)
+    #define RPNG_IDAT_CHUNK_SIZE    (64*1024)
 #endif
 
 #ifndef RPNG_COMPRESSION_LEVEL
@@ -191,12 +246,46 @@
     #define RPNG_COMPRESSION_LEVEL   8
 #endif
 
+#ifndef RPNG_MEMORY_PROFILE
+    // Deflate compressor memory profile, used if not provided on saving options
+    #define RPNG_MEMORY_PROFILE      RPNG_MEMORY_MEDIUM
+#endif
+
 // Define some possible error values
 // NOTE: Only some are actually used on file saving
 #define RPNG_SUCCESS                 0      // Image saved successfully
 #define RPNG_ERROR_FILE_OPEN         1      // The requested file can not be opened
 #define RPNG_ERROR_PIXEL_FORMAT      2      // Not a supported PNG image format
 #define RPNG_ERROR_MEMORY_ALLOC      3      // Memory could not be allocated for operation
+#define RPNG_ERROR_INVALID_DATA      4      // PNG data is not valid or it is corrupted
+#define RPNG_ERROR_BUFFER_SIZE       5      // Provided output buffer capacity is not enough
+
+// Image data output format flags, combined on image loading with output format conversion
+// NOTE: Conversion is applied to every scanline once unfiltered, no additional image data buffers required
+#define RPNG_OUTPUT_DEFAULT          0      // Image data as stored: 1..4 channels, 8/16 bit (16 bit stored big-endian)
+#define RPNG_OUTPUT_RGBA             1      // Expand to 4 channels: gray replicated to RGB, opaque alpha added if not available, indexes expanded
+#define RPNG_OUTPUT_BGRA             2      // Expand to 4 channels, color channels stored in BGRA order
+#define RPNG_OUTPUT_PREMULTIPLY      4      // Color channels multiplied by alpha (only if alpha channel available)
+#define RPNG_OUTPUT_8BIT             8      // 16 bit channels reduced to 8 bit (rounded)
+#define RPNG_OUTPUT_HOST_ENDIAN     16      // 16 bit channels stored in host byte order (PNG data is big-endian)
+
+// Deflate compression strategies, used on image saving options
+// NOTE: RLE and HUFFMAN_ONLY skip matches search, much faster but bigger output (real-time capture)
+#define RPNG_STRATEGY_DEFAULT        0      // Matches search on hash chains, depth defined by compression level
+#define RPNG_STRATEGY_RLE            1      // Only matches at distance 1 and pixel size (runs of filtered data)
+#define RPNG_STRATEGY_HUFFMAN_ONLY   2      // No matches, only filtered data bytes huffman coding
+
+// Color type reduction modes, used on image saving options
+// NOTE: Reduced image data is saved with the smallest lossless color type, loaded format could differ from saved one
+#define RPNG_REDUCE_DEFAULT          0      // Reduce only if RPNG_REDUCE_COLOR_TYPE is defined
+#define RPNG_REDUCE_ENABLED          1      // Reduce color type: alpha removed if opaque, gray, 8 bit or indexed up to 256 colors
+#define RPNG_REDUCE_DISABLED         2      // Save image data with provided color type
+
+// Deflate compressor memory profiles, used on image saving options
+// NOTE: Compressor state is allocated per encoder and sized to data, small data (text chunks, icons) uses less memory
+#define RPNG_MEMORY_SMALL            1      // 4KB window, 4K entries hash, 16KB blocks: ~80KB state (many concurrent encoders, embedded)
+#define RPNG_MEMORY_MEDIUM           2      // 32KB window, 32K entries hash, 256KB blocks: ~1MB state (default)
+#define RPNG_MEMORY_LARGE            3      // 32KB window, 128K entries hash, 256KB blocks: ~1.4MB state (big images, less collisions)
 
 //----------------------------------------------------------------------------------
 // Types and Structures Definition
@@ -204,6 +293,18 @@
 #ifndef __cplusplus
 #include <stdbool.h>        // Boolean type
 #endif
+#include <stddef.h>         // Required for: size_t
+
+// Image rows callback, used on image loading by rows
+//  - Row data is provided unfiltered, in image pixel format: width*color_channels*bit_depth/8 bytes
+//  - Return false to stop image loading
+typedef bool (*rpng_row_callback)(void *user_data, const char *row_data, int row);
+
+// Image pass callback, used on progressive image loading
+//  - Image data is provided every time an Adam7 pass is decoded: pass [1..7], pixels not decoded yet are 0
+//  - Non-interlaced images are provided once, when all image data is decoded (pass 7)
+//  - Return false to stop image loading
+typedef bool (*rpng_pass_callback)(void *user_data, const char *image_data, int pass);
 
 // PNG chunk type
 typedef struct {
@@ -228,6 +329,69 @@ typedef struct {
     rpng_color *colors;     // Palette colors
 } rpng_palette;
 
+// Image type, used on images batch loading and saving
+typedef struct {
+    char *data;             // Image data (NULL if loading failed), to be freed by user
+    int width;              // Image width
+    int height;             // Image height
+    int color_channels;     // Image color channels: 1 (GRAY), 2 (GRAY+ALPHA), 3 (RGB), 4 (RGBA)
+    int bit_depth;          // Image bit depth: 8 bit, 16 bit
+    int result;             // Image loading/saving result: RPNG_SUCCESS or error code
+} rpng_image;
+
+// Image saving statistics, image data compression decisions (filled on saving if requested in options)
+// NOTE: Matches search is skipped on data following a window of searched data barely matched (noise-like data),
+// skipped data is written as literals, blocks are stored uncompressed if literals can not be compressed
+typedef struct {
+    int data_size;              // Image data size filtered (filter type byte per scanline), compressor input
+    int compressed_size;        // Image data size compressed (zlib stream)
+    int blocks_stored;          // Deflate blocks stored uncompressed
+    int blocks_fixed;           // Deflate blocks with fixed huffman codes
+    int blocks_dynamic;         // Deflate blocks with dynamic huffman codes
+    int blocks_search_skipped;  // Deflate blocks with matches search skipped on some data (noise-like data detected)
+} rpng_save_stats;
+
+// Image saving options, zero-initialized options use default values
+typedef struct {
+    int compression_level;  // Deflate compression level [1..9], 0 uses default (RPNG_COMPRESSION_LEVEL), 9 is optimal parsing (slow)
+    bool interlace;         // Save image data interlaced (Adam7), for progressive loading
+    int strategy;           // Deflate compression strategy: RPNG_STRATEGY_DEFAULT, RPNG_STRATEGY_RLE, RPNG_STRATEGY_HUFFMAN_ONLY
+    int memory_profile;     // Deflate compressor memory profile: RPNG_MEMORY_SMALL, RPNG_MEMORY_MEDIUM, RPNG_MEMORY_LARGE, 0 uses default (RPNG_MEMORY_PROFILE)
+    int reduce_color_type;  // Color type reduction: RPNG_REDUCE_ENABLED, RPNG_REDUCE_DISABLED, 0 uses default (enabled if RPNG_REDUCE_COLOR_TYPE defined)
+    rpng_save_stats *stats; // Image saving statistics output (optional, NULL if not required)
+} rpng_save_options;
+
+// Images batch saving callback, called every time one image has been saved to memory
+//  - Index is the image position in the batch, result is RPNG_SUCCESS or error code
+//  - Output data is only valid during callback, it is freed after callback returns
+typedef void (*rpng_save_callback)(void *user_data, int index, const char *output, int output_size, int result);
+
+// PNG data writing callback, used on image saving by rows
+//  - Data is provided by pieces, in file order: signature, IHDR, IDAT chunks and IEND
+//  - Return false to stop image saving
+typedef bool (*rpng_write_callback)(void *user_data, const char *data, int size);
+
+// Image encoder type (opaque), used on image saving by rows
+typedef struct rpng_encoder rpng_encoder;
+
+// Compression codec, zlib streams compression (image data, zTXt chunks) and decompression (image data)
+// NOTE: Codec functions not provided (NULL) use internal sdefl/sinfl, codec can wrap zlib, libdeflate...
+//  - Compression requires compress_bound() and compress(), level [1..9] is provided, other saving options
+//    (strategy, memory profile) and statistics blocks counts are only available with internal compressor
+//  - Streaming functions are optional, without them image data is compressed once all rows are pushed
+//    on saving by rows, and decompressed at once into a temporal buffer on loading
+//  - Zlib data is provided to write callback by pieces on streaming, returning false stops the stream
+typedef struct {
+    void *user_data;            // Codec data, provided to codec functions
+    int (*compress_bound)(void *user_data, int size);   // Maximum zlib stream size for data size
+    int (*compress)(void *user_data, char *output, int output_capacity, const char *data, int size, int level); // Returns zlib stream size, 0 on failure
+    int (*decompress)(void *user_data, char *output, int output_capacity, const char *data, int size);  // Returns data size, -1 on failure (adler32 included)
+    void *(*compress_begin)(void *user_data, int level, rpng_write_callback write, void *write_data);  // Returns compression stream, NULL on failure
+    bool (*compress_write)(void *stream, const char *data, int size);  // Compress data piece, returns false on failure
+    bool (*compress_end)(void *stream, bool finish);    // Flush zlib stream if finish requested (not on aborted streams) and free stream
+    bool (*decompress_stream)(void *user_data, const char *data, int size, rpng_write_callback write, void *write_data); // Returns true if stream fully decompressed
+} rpng_codec;
+
 // A minimal PNG only requires: png_signature | rpng_chunk(IHDR) | rpng_chunk(IDAT) | rpng_chunk(IEND)
 
 #ifdef __cplusplus
@@ -264,19 +428,88 @@ RPNGAPI int rpng_save_image(const char *filename, const char *data, int width, i
 //  - Palette colours are saved as RGB888 in PLTE chunk
 //  - Palette alpha is saved as R8 in tRNS chunk (if required)
 //  - Palette max number of entries is limited to [1..256] colors
+//  - Indexes are saved packed as 1/2/4 bit if palette has 16 colors or less (indexes must fit palette size)
 //  - Returns saving process result: 0-SUCCESS
 RPNGAPI int rpng_save_image_indexed(const char *filename, const char *indexed_data, int width, int height, rpng_palette palette);
 
+// Verify a PNG file integrity: chunks CRC, image data decompression (zlib ADLER32 included), scanlines filters and rows count
+//  - Image data is decoded but not stored, decoding memory is limited to deflate window plus two scanlines
+//  - Returns true if image data can be fully decoded
+RPNGAPI bool rpng_verify(const char *filename);
+
+// Load multiple PNG files image data, distributed between multiple threads (if OpenMP enabled)
+//  - Images info, data and loading result are returned in images array, it must fit count images
+//  - Threads count can be defined, 0 uses all available threads
+//  - Returns number of images loaded successfully
+RPNGAPI int rpng_load_images_batch(const char **filenames, int count, rpng_image *images, int thread_count);
+
+// Save multiple PNG files from images data, distributed between multiple threads (if OpenMP enabled)
+//  - Images define data, size and format to be saved, saving result is returned in image.result
+//  - Threads count can be defined, 0 uses all available threads
+//  - Returns number of images saved successfully
+RPNGAPI int rpng_save_images_batch(const char **filenames, int count, rpng_image *images, int thread_count);
+
+// Save a PNG file from image data with saving options (compression level, interlacing)
+RPNGAPI int rpng_save_image_with_options(const char *filename, const char *data, int width, int height, int color_channels, int bit_depth, rpng_save_options options);
+
+// Begin image saving by rows, PNG data is provided to write callback as soon as it is generated
+//  - PNG signature and IHDR chunk are written on begin, image data is written as IDAT chunks of RPNG_IDAT_CHUNK_SIZE bytes
+//  - Rows are filtered and compressed as soon as they are pushed, full image data is never required
+//  - Encoding memory is limited to deflate window plus one compression block, independent of image height
+//  - Custom codec without streaming compression keeps filtered image data until end, compressed at once
+//  - Returns NULL if image format is not supported or signature could not be written
+RPNGAPI rpng_encoder *rpng_encoder_begin(int width, int height, int color_channels, int bit_depth, rpng_write_callback callback, void *user_data);
+RPNGAPI bool rpng_encoder_push_rows(rpng_encoder *encoder, const char *rows_data, int rows_count);  // Push image rows to encoder, rows data in image pixel format
+RPNGAPI bool rpng_encoder_end(rpng_encoder *encoder);   // End image saving, IEND chunk is written after all rows pushed, encoder is freed
+
+// Load a PNG file image data row by row, every row is provided to callback as soon as it is decoded
+//  - Image info (width, height, color channels, bit depth) is returned by reference, before first row is provided
+//  - Full image data is never stored, decoding memory is limited to deflate window plus two scanlines
+//  - Interlaced images (Adam7) are not supported, use rpng_load_image_progressive() instead
+//  - Returns true if all image rows have been loaded
+RPNGAPI bool rpng_load_image_rows(const char *filename, int *width, int *height, int *color_channels, int *bit_depth, rpng_row_callback callback, void *user_data);
+
+// Load a PNG file image data progressively, image data is provided to callback after every Adam7 pass
+//  - Image info (width, height, color channels, bit depth) is returned by reference, before first pass is provided
+//  - First pass contains 1/64 of image pixels (every 8x8 block top-left pixel), useful to display a coarse preview
+//  - Returns image data, NULL if image could not be loaded or loading was stopped by callback
+RPNGAPI char *rpng_load_image_progressive(const char *filename, int *width, int *height, int *color_channels, int *bit_depth, rpng_pass_callback callback, void *user_data);
+
+// Load a PNG file image data converted to output format: RPNG_OUTPUT_* flags combination
+// NOTE: Color channels and bit depth returned are the output ones, indexed data is expanded with palette if RGBA/BGRA requested
+RPNGAPI char *rpng_load_image_with_format(const char *filename, int *width, int *height, int *color_channels, int *bit_depth, int output_format);
+
+// Load a PNG file image data region: rectangle at image position (x, y), with provided width and height
+// NOTE: Image data is not decoded after last region scanline
+RPNGAPI char *rpng_load_image_region(const char *filename, int x, int y, int width, int height, int *color_channels, int *bit_depth);
+
 // Load and save png data from memory buffer
 // WARNING: Provided buffer is expected to be PNG compliant, ending with IEND chunk
 RPNGAPI char *rpng_load_image_from_memory(const char *buffer, int *width, int *height, int *color_channels, int *bit_depth); // Load png data from memory buffer
 RPNGAPI char *rpng_load_image_indexed_from_memory(const char *buffer, int *width, int *height, rpng_palette *palette); // Load indexed png data from memory buffer (8 bpp)
 RPNGAPI char *rpng_save_image_to_memory(const char *data, int width, int height, int color_channels, int bit_depth, int *output_size); // Save png data to memory buffer
 RPNGAPI char *rpng_save_image_indexed_to_memory(const char *indexed_data, int width, int height, rpng_palette palette, int *output_size); // Save indexed data to memory buffer
+RPNGAPI size_t rpng_save_image_to_buffer(const char *data, int width, int height, int color_channels, int bit_depth, char *output_buffer, size_t output_buffer_capacity); // Save png data into provided buffer, returns size written
+RPNGAPI size_t rpng_save_image_indexed_to_buffer(const char *indexed_data, int width, int height, rpng_palette palette, char *output_buffer, size_t output_buffer_capacity); // Save indexed png data into provided buffer
+RPNGAPI size_t rpng_save_bound(int width, int height, int color_channels, int bit_depth); // Get maximum png data size on image saving, output buffer capacity required
+RPNGAPI char *rpng_save_image_with_options_to_memory(const char *data, int width, int height, int color_channels, int bit_depth, rpng_save_options options, int *output_size); // Save png data to memory buffer with saving options
+RPNGAPI int rpng_save_images_batch_to_memory(rpng_image *images, int count, char **outputs, int *output_sizes, int thread_count); // Save multiple png images to memory buffers (in input order)
+RPNGAPI int rpng_save_images_batch_to_callback(rpng_image *images, int count, rpng_save_callback callback, void *user_data, int thread_count); // Save multiple png images to memory, provided to callback once compressed
+RPNGAPI bool rpng_verify_from_memory(const char *buffer);   // Verify png data integrity from memory buffer
+RPNGAPI int rpng_load_images_batch_from_memory(const char **buffers, int count, rpng_image *images, int thread_count); // Load multiple png images from memory buffers
+RPNGAPI bool rpng_load_image_rows_from_memory(const char *buffer, int *width, int *height, int *color_channels, int *bit_depth, rpng_row_callback callback, void *user_data); // Load png data row by row from memory buffer
+RPNGAPI char *rpng_load_image_progressive_from_memory(const char *buffer, int *width, int *height, int *color_channels, int *bit_depth, rpng_pass_callback callback, void *user_data); // Load png data progressively from memory buffer
+RPNGAPI char *rpng_load_image_with_format_from_memory(const char *buffer, int *width, int *height, int *color_channels, int *bit_depth, int output_format); // Load png data from memory buffer converted to output format
+RPNGAPI char *rpng_load_image_region_from_memory(const char *buffer, int x, int y, int width, int height, int *color_channels, int *bit_depth); // Load png data region from memory buffer
 
 // Convert indexed image data to RGBA data
 RPNGAPI char *rpng_unindex_image_data(char *indexed_data, int width, int height, rpng_palette palette);
 
+// Set compression codec used for image data and compressed text chunks, NULL restores internal sdefl/sinfl
+//  - Codec is copied, compression and decompression functions not provided keep using internal codec
+//  - WARNING: Codec is shared by all threads, it must be set before images loading/saving
+RPNGAPI void rpng_set_codec(const rpng_codec *codec);
+
 // Read and write chunks from file
 RPNGAPI int rpng_chunk_count(const char *filename);                                  // Count the chunks in a PNG image
 RPNGAPI rpng_chunk rpng_chunk_read(const char *filename, const char *chunk_type);    // Read one chunk type
@@ -297,6 +530,7 @@ RPNGAPI void rpng_chunk_write_chroma(const char *filename, float white_x, float
 // Chunk utilities
 RPNGAPI void rpng_chunk_print_info(const char *filename);                            // Output info about the chunks
 RPNGAPI bool rpng_chunk_check_all_valid(const char *filename);                       // Check chunks CRC is valid
+RPNGAPI int rpng_chunk_find_invalid(const char *filename, size_t *offset);           // Find first chunk with invalid CRC, returns chunk index, -1 if all valid or -2 on error
 RPNGAPI void rpng_chunk_combine_image_data(const char *filename);                    // Combine multiple IDAT chunks into a single one
 RPNGAPI void rpng_chunk_split_image_data(const char *filename, int split_size);      // Split one IDAT chunk into multiple ones
 
@@ -309,6 +543,17 @@ RPNGAPI char *rpng_chunk_remove_ancillary_from_memory(const char *buffer, int *o
 RPNGAPI char *rpng_chunk_write_from_memory(const char *buffer, rpng_chunk chunk, int *output_size);         // Write one new chunk after IHDR (any kind)
 RPNGAPI char *rpng_chunk_combine_image_data_from_memory(char *buffer, int *output_size);                    // Combine multiple IDAT chunks into a single one
 RPNGAPI char *rpng_chunk_split_image_data_from_memory(char *buffer, int split_size, int *output_size);      // Split one IDAT chunk into multiple ones
+RPNGAPI bool rpng_chunk_check_all_valid_from_memory(const char *buffer);                                    // Check chunks CRC is valid from memory
+RPNGAPI int rpng_chunk_find_invalid_from_memory(const char *buffer, size_t *offset);                        // Find first chunk with invalid CRC from memory, returns chunk index, -1 if all valid or -2 on error
+
+// Chunk management functions: write into provided output buffer
+// NOTE: Functions return required output size, output data is only complete if output buffer capacity fits it,
+// use output_buffer = NULL to just query the required size, sizes are not limited to int range (files bigger than 2GB)
+RPNGAPI size_t rpng_chunk_remove_to_buffer(const char *buffer, const char *chunk_type, char *output_buffer, size_t output_buffer_capacity);    // Remove one chunk type
+RPNGAPI size_t rpng_chunk_remove_ancillary_to_buffer(const char *buffer, char *output_buffer, size_t output_buffer_capacity);                 // Remove all chunks except: IHDR-PLTE-IDAT-IEND
+RPNGAPI size_t rpng_chunk_write_to_buffer(const char *buffer, rpng_chunk chunk, char *output_buffer, size_t output_buffer_capacity);          // Write one new chunk after IHDR (any kind)
+RPNGAPI size_t rpng_chunk_combine_image_data_to_buffer(const char *buffer, char *output_buffer, size_t output_buffer_capacity);               // Combine multiple IDAT chunks into a single one
+RPNGAPI size_t rpng_chunk_split_image_data_to_buffer(const char *buffer, int split_size, char *output_buffer, size_t output_buffer_capacity);  // Split IDAT chunks into multiple ones
 
 #ifdef __cplusplus
 }
@@ -329,12 +574,31 @@ RPNGAPI char *rpng_chunk_split_image_data_from_memory(char *buffer, int split_si
 #endif
 
 #include <stdlib.h>         // Required for: malloc(), calloc(), free()
-#include <string.h>         // Required for: memcmp(), memcpy()
+#include <string.h>         // Required for: memcmp(), memcpy(), memset()
+
+#if defined(_OPENMP)
+    #include <omp.h>        // Required for: omp_get_max_threads()
+#endif
 
 #if defined(_WIN32) && defined(_MSC_VER)
     #include <io.h>         // Required for: _access() [file_exists()]
 #else
-    #include <unistd.h>     // Required for: access() (POSIX, not C standard) [file_exists()]
+    #include <unistd.h>     // Required for: access(), close() (POSIX, not C standard) [file_exists()]
+#endif
+
+#if !defined(RPNG_NO_STDIO) && !defined(_WIN32)
+    #include <fcntl.h>      // Required for: open() [save_file_from_pieces()]
+    #include <sys/uio.h>    // Required for: writev() [save_file_from_pieces()]
+#endif
+
+#if !defined(RPNG_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+    #include <emmintrin.h>  // Required for: SSE2 intrinsics [rpng_convert_row()]
+    #define RPNG_SSE2
+#endif
+
+#if !defined(RPNG_NO_SIMD) && defined(__AVX2__)
+    #include <immintrin.h>  // Required for: AVX2 intrinsics [rpng_expand_row()]
+    #define RPNG_AVX2
 #endif
 
 //----------------------------------------------------------------------------------
@@ -469,29 +733,197 @@ typedef struct {
 //fcTL: Frame Control
 //fdAT: Frame Data
 
+// Image data scanlines decoder
+// NOTE: Decompressed image data is received by pieces, every scanline is unfiltered when completed
+// and provided to the rows processor, only current and previous scanlines are kept in memory
+typedef struct rpng_row_decoder {
+    int width;                      // Image width
+    int height;                     // Image height
+    int bits_per_pixel;             // Bits per pixel: color channels*bit depth
+    int pixel_size;                 // Bytes per pixel for filtering (minimum 1 byte)
+    int color_channels;             // Color channels per pixel
+    int bit_depth;                  // Bit depth per channel once unpacked: 8, 16
+    bool indexed;                   // Indexed image data, indexes expanded with palette lookup table if conversion required
+    int interlace;                  // Interlace scheme: 0 (none), 1 (Adam7)
+    int pass;                       // Current pass: 0 if not interlaced, [0..6] for Adam7
+    int pass_width;                 // Current pass width in pixels
+    int pass_height;                // Current pass height in pixels
+    int row;                        // Current scanline in pass
+    int row_size;                   // Current pass scanline size in bytes (filter type byte not included)
+    int row_fill;                   // Current scanline bytes received (filter type byte included)
+    unsigned char *row_current;     // Current scanline: filter type byte + data
+    unsigned char *row_previous;    // Previous scanline unfiltered: filter type byte + data
+    int row_capacity;               // Scanlines allocated size, kept between images if decoder is reused
+    int row_output_size;            // Current pass scanline size provided to rows processor (unpacked if required)
+    int unpack_depth;               // Bit depth to unpack into 8 bit values: 1, 2, 4 (0 if not required)
+    unsigned char *row_unpacked;    // Current scanline unpacked: 1 byte per pixel (only for bit depths 1/2/4)
+    unsigned char unpack_lut[256*8]; // Unpacking lookup table: 8 bit values for every packed byte value
+    int output_format;              // Output format conversion required: RPNG_OUTPUT_* flags (0 if not required)
+    int output_pixel_size;          // Bytes per pixel provided to rows processor (unpacked/converted)
+    unsigned char *row_converted;   // Current scanline converted to output format (only if conversion required)
+    unsigned int palette_lut[256];  // Palette colors lookup table: colors packed in output byte order (only for indexed data expansion)
+    unsigned char *window;          // Decompression window, kept between images if decoder is reused
+    bool (*process_row)(struct rpng_row_decoder *decoder, const unsigned char *row); // Rows processor, returns false to stop decoding
+    void *user_data;                // Rows processor data
+    bool complete;                  // All scanlines have been decoded
+    bool failed;                    // Invalid data found while decoding
+} rpng_row_decoder;
+
+// Image data compression context, it can be reused between images
+typedef struct {
+    struct sdefl *sde;              // Deflate compressor state
+    unsigned char *data_filtered;   // Image data filtered (filter type byte added per scanline)
+    size_t data_filtered_capacity;  // Image data filtered allocated size
+} rpng_deflate_context;
+
+// Image encoder, used on image saving by rows
+// NOTE: Every scanline is filtered and compressed as soon as it is provided, compressed data
+// is accumulated into current IDAT chunk and written to callback when chunk is full
+struct rpng_encoder {
+    int width;                      // Image width
+    int height;                     // Image height
+    int pixel_size;                 // Bytes per pixel for filtering
+    int row;                        // Next scanline to be provided
+    int row_size;                   // Scanline size in bytes (filter type byte not included)
+    unsigned char *row_previous;    // Previous scanline: data
+    unsigned char *row_filtered;    // Current scanline filtered: filter type byte + data
+    struct sdefl *sde;              // Deflate compressor state
+    struct sdefl_stream *stream;    // Deflate compressor stream: input window and output block
+    void *codec_stream;             // Codec compression stream (only custom codec with streaming)
+    unsigned char *data_filtered;   // Image data filtered, compressed on end (only custom codec without streaming)
+    unsigned char *chunk;           // Current IDAT chunk: length + type + data + crc
+    int chunk_fill;                 // Current IDAT chunk data size
+    rpng_write_callback callback;   // User write callback
+    void *user_data;                // User write callback data
+    bool failed;                    // Data could not be compressed or written
+};
+
+// PNG data piece, used to write PNG data from multiple pieces without joining them
+typedef struct {
+    const void *data;               // Piece data
+    size_t size;                    // Piece data size
+} rpng_data_piece;
+
+// Image rows callback data, used by rows processor on image loading by rows
+typedef struct {
+    rpng_row_callback callback;     // User rows callback
+    void *user_data;                // User rows callback data
+} rpng_row_callback_data;
+
+// Image pass callback data, used by rows processor on progressive image loading
+typedef struct {
+    char *data;                     // Image data, scanlines stored as decoded
+    rpng_pass_callback callback;    // User pass callback
+    void *user_data;                // User pass callback data
+} rpng_pass_callback_data;
+
+// Image region data, used by rows processor on image region loading
+typedef struct {
+    char *data;                     // Region image data
+    int x;                          // Region position X in image
+    int y;                          // Region position Y in image
+    int width;                      // Region width
+    int height;                     // Region height
+    bool complete;                  // All region scanlines have been stored
+} rpng_region_data;
+
 //----------------------------------------------------------------------------------
 // Global Variables Definition
 //----------------------------------------------------------------------------------
 const unsigned char png_signature[8] = { 0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a }; // PNG Signature
 
+// Compression codec set by user, functions not provided (NULL) use internal sdefl/sinfl
+static rpng_codec rpng_codec_custom = { 0 };
+
+// Adam7 interlace passes: starting pixel and pixels step
+static const int adam7_x_start[7] = { 0, 4, 0, 2, 0, 1, 0 };
+static const int adam7_y_start[7] = { 0, 0, 4, 0, 2, 0, 1 };
+static const int adam7_x_step[7] = { 8, 8, 4, 4, 2, 2, 1 };
+static const int adam7_y_step[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+// Maximum data size to be compressed in a single call (sdefl sizes are int),
+// some margin is left for deflate blocks overhead
+#define RPNG_MAX_DEFLATE_SIZE   (0x7fffffff - 0x100000)
+
+// Maximum PNG data header size on image saving:
+// signature + IHDR + PLTE (256 colors) + tRNS (256 colors) + IDAT length and type
+#define RPNG_MAX_DATA_PIECES    8
+
+#define RPNG_MAX_HEADER_SIZE    (8 + (12 + 13) + (12 + 256*3) + (12 + 256) + 8)
+
 //----------------------------------------------------------------------------------
 // Module specific Functions Declaration
 //----------------------------------------------------------------------------------
 // Prefilter and compress image data (image_data -> IDAT chunk.data)
-static char *rpng_inflate_image_data(char *image_data, int image_data_size, int width, int height, int pixel_size);
-// Decompress and unfilter image data (IDAT chunk.data -> image_data)
-static char *rpng_deflate_image_data(const char *image_data, int image_data_size, int width, int height, int pixel_size, int *output_size, int forced_filter_type);
+static void rpng_filter_row(unsigned char *output, const unsigned char *row, const unsigned char *previous, int size, int pixel_size, int filter);
+static struct sdefl *rpng_deflate_create(struct sdefl *sde, int memory_profile, size_t data_size);
+static int rpng_compress_bound(int size);
+static void rpng_deflate_context_close(rpng_deflate_context *context);
+static int rpng_deflate_image_data(rpng_deflate_context *context, const char *image_data, int width, int height, int pixel_size, int pack_depth, int forced_filter_type, const rpng_save_options *options, unsigned char *output);
+static void rpng_gather_row(unsigned char *row, const unsigned char *image_data, int width, int pixel_size, int pass, int pass_row, int pass_width);
+
+// PNG data generation around compressed image data (header -> IDAT chunk.data -> trailer)
+static int rpng_store_chunk(unsigned char *output, const char *type, const unsigned char *data, int length);
+static int rpng_write_image_header(unsigned char *output, int width, int height, int color_type, int bit_depth, int interlace, const rpng_palette *palette);
+static int rpng_write_image_trailer(unsigned char *output, unsigned char *header, int header_size, const unsigned char *idat_data, int idat_size);
+
+// Image data scanlines decoding (IDAT chunk.data -> rows processor)
+static bool rpng_check_image_info(const rpng_chunk_IHDR *image_info);
+static bool rpng_read_image_info(const char *buffer, rpng_chunk_IHDR *image_info);
+static int rpng_get_color_channels(int color_type);
+static int rpng_get_color_type(int color_channels);
+static size_t rpng_get_image_data_size(int width, int height, int bits_per_pixel);
+static size_t rpng_get_filtered_data_size(int width, int height, int bits_per_pixel, bool interlace);
+static void rpng_get_pass_size(int width, int height, int pass, int *pass_width, int *pass_height);
+static const char *rpng_find_chunk(const char *buffer, const char *chunk_type);
+static const char *rpng_get_image_data(const char *buffer, size_t *image_data_size, bool *image_data_copy);
+static void rpng_get_output_format(const rpng_chunk_IHDR *image_info, int output_format, int *color_channels, int *bit_depth);
+static bool rpng_decode_image_data(rpng_row_decoder *context, const char *buffer, const rpng_chunk_IHDR *image_info, int output_format, bool (*process_row)(rpng_row_decoder *decoder, const unsigned char *row), void *user_data);
+static int rpng_load_image_data(rpng_row_decoder *context, const char *buffer, int output_format, rpng_image *image);
+static int rpng_save_image_data(rpng_deflate_context *context, const char *data, int width, int height, int color_channels, int bit_depth, const rpng_palette *palette, const rpng_save_options *options, const char *filename, char *output_buffer, size_t output_buffer_capacity, size_t *output_size);
+static int rpng_save_image_data_to_memory(rpng_deflate_context *context, const char *data, int width, int height, int color_channels, int bit_depth, const rpng_palette *palette, const rpng_save_options *options, char **output, int *output_size);
+static char *rpng_reduce_image_data(const char *data, int width, int height, int *color_channels, int *bit_depth, rpng_palette *palette);
+static int rpng_save_images(const char **filenames, rpng_image *images, int count, char **outputs, int *output_sizes, rpng_save_callback callback, void *user_data, int thread_count);
+static int rpng_load_images(const char **sources, bool sources_are_files, int count, rpng_image *images, int thread_count);
+static bool rpng_store_row(rpng_row_decoder *decoder, const unsigned char *row);
+static bool rpng_store_row_interlaced(rpng_row_decoder *decoder, const unsigned char *row);
+static bool rpng_progressive_row(rpng_row_decoder *decoder, const unsigned char *row);
+static bool rpng_store_region_row(rpng_row_decoder *decoder, const unsigned char *row);
+static void rpng_scatter_row(unsigned char *image_data, const rpng_row_decoder *decoder, const unsigned char *row);
+static bool rpng_callback_row(rpng_row_decoder *decoder, const unsigned char *row);
+static bool rpng_row_decoder_init(rpng_row_decoder *decoder, const rpng_chunk_IHDR *image_info);
+static void rpng_row_decoder_close(rpng_row_decoder *decoder);
+static bool rpng_row_decoder_decode(rpng_row_decoder *decoder, const char *image_data, int image_data_size);
+static void rpng_unfilter_row(unsigned char *row, const unsigned char *previous, int filter, int size, int pixel_size);
+static void rpng_unpack_row(unsigned char *output, const unsigned char *row, int width, int bit_depth, const unsigned char *lut);
+static void rpng_pack_row(unsigned char *output, const unsigned char *row, int width, int bit_depth);
+static int rpng_get_row_conversion(int color_channels, int bit_depth, int output_format);
+static void rpng_convert_row(unsigned char *output, const unsigned char *row, int width, int color_channels, int bit_depth, int conversion);
+static void rpng_convert_pixels(unsigned char *output, const unsigned char *row, int start, int width, int color_channels, int bit_depth, int conversion);
+static void rpng_get_palette_lut(unsigned int *lut, const rpng_color *colors, int color_count, int output_format);
+static bool rpng_read_palette_lut(const char *buffer, int output_format, unsigned int *lut);
+static void rpng_expand_row(unsigned char *output, const unsigned char *row, int width, const unsigned int *lut);
+static int rpng_encoder_write(void *user_data, const unsigned char *data, int size);
+static bool rpng_encoder_write_codec(void *user_data, const char *data, int size);
+static bool rpng_encoder_write_chunk(rpng_encoder *encoder);
+static void rpng_encoder_close(rpng_encoder *encoder);
 
 // Swap integer from big<->little endian
 static unsigned int swap_endian(unsigned int value);
+static bool is_little_endian(void);
 static unsigned int compute_crc32(unsigned char *buffer, int size);
+static unsigned int update_crc32(unsigned int crc, const unsigned char *buffer, int size);
 
 // Load/save png file data from/to memory buffer
-static char *load_file_to_buffer(const char *filename, int *bytes_read);
-static int save_file_from_buffer(const char *filename, void *data, int bytesToWrite);
+static char *load_file_to_buffer(const char *filename, size_t *bytes_read);
+static int save_file_from_buffer(const char *filename, void *data, size_t bytesToWrite);
+static int save_file_from_pieces(const char *filename, const rpng_data_piece *pieces, int count);
 static bool file_exists(const char *filename);
 
 // sdelf and sinfl implementations placed at the end of file
+// NOTE: sdefl allocates compressor state and streams buffers, sized by memory profile
+#define SDEFL_MALLOC(sz)    RPNG_MALLOC(sz)
+#define SDEFL_FREE(ptr)     RPNG_FREE(ptr)
 #define SDEFL_IMPLEMENTATION
 #define SINFL_IMPLEMENTATION
 
@@ -500,16 +932,20 @@ static bool file_exists(const char *filename);
 // DEFLATE COMPRESSION algorithm: https://github.com/vurtun/sdefl
 //===================================================================
 #define SDEFL_MAX_OFF   (1 << 15)
-#define SDEFL_WIN_SIZ   SDEFL_MAX_OFF
-#define SDEFL_WIN_MSK   (SDEFL_WIN_SIZ-1)
 
-#define SDEFL_HASH_BITS 15
-#define SDEFL_HASH_SIZ  (1 << SDEFL_HASH_BITS)
-#define SDEFL_HASH_MSK  (SDEFL_HASH_SIZ-1)
+/* memory profile defaults and limits (see sdefl_create()): hash table and
+ * window are int arrays, sequences take 8 bytes for every 3 bytes of block */
+#define SDEFL_WIN_BITS      15
+#define SDEFL_WIN_BITS_MIN  8
+#define SDEFL_HASH_BITS     15
+#define SDEFL_HASH_BITS_MIN 8
+#define SDEFL_HASH_BITS_MAX 20
 
 #define SDEFL_MIN_MATCH 4
 #define SDEFL_BLK_MAX   (256*1024)
-#define SDEFL_SEQ_SIZ   ((SDEFL_BLK_MAX+2)/3)
+#define SDEFL_BLK_MAX_MIN (8*1024)
+#define SDEFL_BLK_MIN   (10000)
+#define SDEFL_OBS_NUM   (10)
 
 #define SDEFL_SYM_MAX   (288)
 #define SDEFL_OFF_MAX   (32)
@@ -517,7 +953,15 @@ static bool file_exists(const char *filename);
 
 #define SDEFL_LVL_MIN   0
 #define SDEFL_LVL_DEF   5
-#define SDEFL_LVL_MAX   8
+#define SDEFL_LVL_OPT   9
+#define SDEFL_LVL_MAX   9
+
+/* compression strategies (struct sdefl strat, zero-initialized is default):
+ * RLE only looks for matches at distance 1 and at strat_dist (i.e. pixel size),
+ * HUFF only emits literals, both skip hash chains search and ignore level */
+#define SDEFL_STRAT_DEF  0
+#define SDEFL_STRAT_RLE  1
+#define SDEFL_STRAT_HUFF 2
 
 struct sdefl_freq {
   unsigned lit[SDEFL_SYM_MAX];
@@ -538,39 +982,104 @@ struct sdefl_codes {
 struct sdefl_seqt {
   int off, len;
 };
+struct sdefl_split {
+  /* block symbols statistics: literal classes and short/long matches */
+  unsigned obs[SDEFL_OBS_NUM], new_obs[SDEFL_OBS_NUM];
+  unsigned obs_cnt, new_obs_cnt;
+};
+/* blocks statistics of last compression (sdeflate(), zsdeflate() or stream) */
+struct sdefl_stats {
+  int blk_raw, blk_fixed, blk_dyn; /* blocks written by type */
+  int blk_lit; /* blocks with matches search skipped on some input: noise-like data */
+};
+struct sdefl_probe {
+  /* matches search of greedy levels is evaluated on windows of searched input,
+   * search is skipped on next input (still hashed) if barely anything matched */
+  int cnt, matched; /* searched and matched bytes of current window */
+  int skip; /* bytes left to skip search */
+};
 struct sdefl {
-  int bits, bitcnt;
-  int tbl[SDEFL_HASH_SIZ];
-  int prv[SDEFL_WIN_SIZ];
+  unsigned long long bits;
+  int bitcnt;
+  int strat, strat_dist;
+  struct sdefl_stats stats;
+
+  /* memory profile, state arrays are allocated with struct by sdefl_create() */
+  int hash_bits, win_bits, win_siz, blk_max, seq_siz;
+  int *tbl; /* [1 << hash_bits] */
+  int *prv; /* [win_siz] */
+
+  struct sdefl_split split;
+  struct sdefl_probe probe;
 
   int seq_cnt;
-  struct sdefl_seqt seq[SDEFL_SEQ_SIZ];
+  struct sdefl_seqt *seq; /* [seq_siz] */
   struct sdefl_freq freq;
   struct sdefl_codes cod;
 };
+/* compressor state sized at runtime: hash table of 2^hash_bits entries,
+ * window of 2^win_bits bytes [8..15] and blocks up to blk_max bytes,
+ * zero or negative values use defaults, returns NULL on allocation failure */
+extern struct sdefl *sdefl_create(int hash_bits, int win_bits, int blk_max);
+extern void sdefl_destroy(struct sdefl *s);
 extern int sdefl_bound(int in_len);
 extern int sdeflate(struct sdefl *s, void *o, const void *i, int n, int lvl);
 extern int zsdeflate(struct sdefl *s, void *o, const void *i, int n, int lvl);
 
+/* streaming compression: input is provided by pieces and compressed data is
+ * provided to a write callback (returning non-zero aborts compression) every
+ * time a block is completed, only last window of input is kept for matches,
+ * generated zlib stream is the same than zsdeflate() one, returns 0 on success */
+typedef int (*sdefl_write_func)(void *usr, const unsigned char *data, int len);
+struct sdefl_stream {
+  sdefl_write_func write;
+  void *usr;
+  int lvl, pos, len, cap;
+  unsigned adler;
+  unsigned char *in;  /* [cap] = 2*win_siz + blk_max + SDEFL_MIN_MATCH + 1 */
+  unsigned char *out; /* [blk_max + 64] */
+};
+/* stream buffers are allocated by zsdeflate_begin() and released by
+ * zsdeflate_end(), zsdeflate_free() releases them on aborted streams */
+extern int zsdeflate_begin(struct sdefl *s, struct sdefl_stream *z, int lvl, sdefl_write_func write, void *usr);
+extern int zsdeflate_write(struct sdefl *s, struct sdefl_stream *z, const void *in, int n);
+extern int zsdeflate_end(struct sdefl *s, struct sdefl_stream *z);
+extern void zsdeflate_free(struct sdefl_stream *z);
+
 //=========================================================================
 //                           SINFL
 // DEFLATE DECOMPRESSION algorithm: https://github.com/vurtun/lib/sinfl.h
 //=========================================================================
 #define SINFL_PRE_TBL_SIZE 128
-#define SINFL_LIT_TBL_SIZE 1334
+#define SINFL_LIT_TBL_BITS 11
+#define SINFL_LIT_TBL_SIZE 2342 /* root table and largest sub-tables of 288 codes */
 #define SINFL_OFF_TBL_SIZE 402
 
 struct sinfl {
   const unsigned char *bitptr;
+  const unsigned char *bitend;
   unsigned long long bitbuf;
   int bitcnt;
+  int bitover; /* zero bytes added past input end */
 
   unsigned lits[SINFL_LIT_TBL_SIZE];
   unsigned dsts[SINFL_OFF_TBL_SIZE];
 };
 
+#define SINFL_WIN_SIZ (1 << 15)
+
+/* input is never read past in + size: buffers can be decompressed in place
+ * without padding (memory mapped files, chunks data inside a PNG buffer) */
+
+/* streaming decompression: decompressed data is provided by pieces to a write
+ * callback (returning non-zero aborts decompression), provided buffer is used as
+ * sliding window and must be at least 2*SINFL_WIN_SIZ bytes, returns 0 on success */
+typedef int (*sinfl_write_func)(void *usr, const unsigned char *data, int len);
+
 extern int sinflate(void *out, int cap, const void *in, int size);
 extern int zsinflate(void *out, int cap, const void *in, int size);
+extern int sinflate_stream(void *buf, int cap, const void *in, int size, sinfl_write_func write, void *usr);
+extern int zsinflate_stream(void *buf, int cap, const void *in, int size, sinfl_write_func write, void *usr);
 
 //----------------------------------------------------------------------------------
 // Module Functions Definition
@@ -603,7 +1112,7 @@ char *rpng_load_image(const char *filename, int *width, int *height, int *color_
 {
     char *data = NULL;
 
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -622,7 +1131,7 @@ char *rpng_load_image_indexed(const char *filename, int *width, int *height, rpn
 {
     char *data = NULL;
 
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -637,42 +1146,151 @@ char *rpng_load_image_indexed(const char *filename, int *width, int *height, rpn
 // Save a PNG file from image data (IHDR, IDAT, IEND)
 //  - Color channels defines pixel color channels, supported values: 1 (GRAY), 2 (GRAY+ALPHA), 3 (RGB), 4 (RGBA)
 //  - Bit depth defines every color channel size, supported values: 8 bit, 16 bit
+//  - PNG data pieces are written directly to file, no full PNG data buffer is generated
 int rpng_save_image(const char *filename, const char *data, int width, int height, int color_channels, int bit_depth)
 {
-    int result = 0;
+    int result = rpng_save_image_data(NULL, data, width, height, color_channels, bit_depth, NULL, NULL, filename, NULL, 0, NULL);
 
-    int file_output_size = 0;
-    char *file_output = rpng_save_image_to_memory(data, width, height, color_channels, bit_depth, &file_output_size);
+    if (result != RPNG_SUCCESS) RPNG_LOG("WARNING: PNG data saving failed\n");
 
-    if ((file_output != NULL) && (file_output_size > 0))
-    {
-        save_file_from_buffer(filename, file_output, file_output_size);
-    }
-    else RPNG_LOG("WARNING: PNG data saving failed");
+    return result;
+}
 
-    RPNG_FREE(file_output);
+// Save a PNG file from image data with saving options
+//  - Options: compression level (0 for default, 9 for smallest output), interlace (Adam7 passes, for progressive loading),
+//    compression strategy (RLE and Huffman only are faster, compression level is ignored)
+int rpng_save_image_with_options(const char *filename, const char *data, int width, int height, int color_channels, int bit_depth, rpng_save_options options)
+{
+    int result = rpng_save_image_data(NULL, data, width, height, color_channels, bit_depth, NULL, &options, filename, NULL, 0, NULL);
+
+    if (result != RPNG_SUCCESS) RPNG_LOG("WARNING: PNG data saving failed\n");
 
     return result;
 }
 
+// Save multiple PNG files from images data
+//  - Images are compressed and saved concurrently if OpenMP is enabled, thread_count = 0 uses all available threads
+//  - Every image saving result is returned in image.result, RPNG_SUCCESS if saved
+//  - Returns number of images saved successfully
+int rpng_save_images_batch(const char **filenames, int count, rpng_image *images, int thread_count)
+{
+    if (filenames == NULL) return 0;
+
+    return rpng_save_images(filenames, images, count, NULL, NULL, NULL, NULL, thread_count);
+}
+
 // Save a PNG file from indexed image data (IHDR, PLTE, (tRNS), IDAT, IEND)
 //  - Palette colours are saved as RGB888 in PLTE chunk
 //  - Palette alpha is saved as R8 in tRNS chunk (if required)
 //  - Palette max number of entries is limited to [1..256] colors
+//  - Indexes are saved packed as 1/2/4 bit if palette has 16 colors or less (indexes must fit palette size)
 int rpng_save_image_indexed(const char *filename, const char *indexed_data, int width, int height, rpng_palette palette)
 {
-    int result = 0;
+    int result = rpng_save_image_data(NULL, indexed_data, width, height, 1, 8, &palette, NULL, filename, NULL, 0, NULL);
 
-    int file_output_size = 0;
-    char *file_output = rpng_save_image_indexed_to_memory(indexed_data, width, height, palette, &file_output_size);
+    if (result != RPNG_SUCCESS) RPNG_LOG("WARNING: PNG data saving failed\n");
+
+    return result;
+}
+
+// Load multiple PNG files image data
+//  - Files are loaded and decoded concurrently if OpenMP is enabled, thread_count = 0 uses all available threads
+//  - Every image loading result is returned in image.result, RPNG_SUCCESS if loaded
+//  - Returns number of images loaded successfully
+int rpng_load_images_batch(const char **filenames, int count, rpng_image *images, int thread_count)
+{
+    return rpng_load_images(filenames, true, count, images, thread_count);
+}
+
+// Load a PNG file image data row by row
+// NOTE: File is loaded into memory, image data is not
+bool rpng_load_image_rows(const char *filename, int *width, int *height, int *color_channels, int *bit_depth, rpng_row_callback callback, void *user_data)
+{
+    bool result = false;
+
+    size_t file_size = 0;
+    char *file_data = load_file_to_buffer(filename, &file_size);
+
+    if (file_data != NULL)
+    {
+        result = rpng_load_image_rows_from_memory(file_data, width, height, color_channels, bit_depth, callback, user_data);
+        RPNG_FREE(file_data);
+    }
+
+    return result;
+}
+
+// Load a PNG file image data progressively, image data is provided to callback after every Adam7 pass
+char *rpng_load_image_progressive(const char *filename, int *width, int *height, int *color_channels, int *bit_depth, rpng_pass_callback callback, void *user_data)
+{
+    char *data = NULL;
+
+    size_t file_size = 0;
+    char *file_data = load_file_to_buffer(filename, &file_size);
 
-    if ((file_output != NULL) && (file_output_size > 0))
+    if (file_data != NULL)
     {
-        save_file_from_buffer(filename, file_output, file_output_size);
+        data = rpng_load_image_progressive_from_memory(file_data, width, height, color_channels, bit_depth, callback, user_data);
+        RPNG_FREE(file_data);
+    }
+
+    return data;
+}
+
+// Load a PNG file image data converted to output format
+//  - Output format is a combination of RPNG_OUTPUT_* flags, i.e. (RPNG_OUTPUT_BGRA | RPNG_OUTPUT_PREMULTIPLY | RPNG_OUTPUT_8BIT)
+//  - Color channels and bit depth are returned by reference, they are the output format ones
+//  - Indexed image data is expanded with palette colors (PLTE, tRNS) if RGBA/BGRA output is requested
+char *rpng_load_image_with_format(const char *filename, int *width, int *height, int *color_channels, int *bit_depth, int output_format)
+{
+    char *data = NULL;
+
+    size_t file_size = 0;
+    char *file_data = load_file_to_buffer(filename, &file_size);
+
+    if (file_data != NULL)
+    {
+        data = rpng_load_image_with_format_from_memory(file_data, width, height, color_channels, bit_depth, output_format);
+        RPNG_FREE(file_data);
+    }
+
+    return data;
+}
+
+// Load a PNG file image data region
+//  - Region rectangle must be inside image, color channels and bit depth are returned by reference
+//  - Image data is decoded until last region scanline, only region pixels are stored
+char *rpng_load_image_region(const char *filename, int x, int y, int width, int height, int *color_channels, int *bit_depth)
+{
+    char *data = NULL;
+
+    size_t file_size = 0;
+    char *file_data = load_file_to_buffer(filename, &file_size);
+
+    if (file_data != NULL)
+    {
+        data = rpng_load_image_region_from_memory(file_data, x, y, width, height, color_channels, bit_depth);
+        RPNG_FREE(file_data);
+    }
+
+    return data;
+}
+
+// Verify a PNG file integrity: chunks CRC, image data decompression, scanlines filters and rows count
+// NOTE: File is loaded into memory, use rpng_verify_from_memory() with mapped file data to avoid it
+bool rpng_verify(const char *filename)
+{
+    bool result = false;
+
+    size_t file_size = 0;
+    char *file_data = load_file_to_buffer(filename, &file_size);
+
+    if (file_data != NULL)
+    {
+        result = rpng_verify_from_memory(file_data);
+        RPNG_FREE(file_data);
     }
-    else RPNG_LOG("WARNING: PNG data saving failed");
 
-    RPNG_FREE(file_output);
     return result;
 }
 
@@ -680,7 +1298,7 @@ int rpng_save_image_indexed(const char *filename, const char *indexed_data, int
 int rpng_chunk_count(const char *filename)
 {
     int count = 0;
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -698,7 +1316,7 @@ rpng_chunk rpng_chunk_read(const char *filename, const char *chunk_type)
 {
     rpng_chunk chunk = { 0 };
 
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -716,7 +1334,7 @@ rpng_chunk *rpng_chunk_read_all(const char *filename, int *count)
     int counter = 0;
     rpng_chunk *chunks = NULL;
 
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -732,7 +1350,7 @@ rpng_chunk *rpng_chunk_read_all(const char *filename, int *count)
 // Remove text chunk by type
 void rpng_chunk_remove(const char *filename, const char *chunk_type)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -749,7 +1367,7 @@ void rpng_chunk_remove(const char *filename, const char *chunk_type)
 // Remove all chunks except: IHDR-IDAT-IEND
 void rpng_chunk_remove_ancillary(const char *filename)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -767,7 +1385,7 @@ void rpng_chunk_remove_ancillary(const char *filename)
 // NOTE: Chunk is added by default after IHDR
 void rpng_chunk_write(const char *filename, rpng_chunk chunk)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     int file_output_size = 0;
@@ -778,7 +1396,7 @@ void rpng_chunk_write(const char *filename, rpng_chunk chunk)
         file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
 
         // Verify expected output size before writing to file
-        if (file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
+        if ((size_t)file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
         else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
 
         RPNG_FREE(file_output);
@@ -804,7 +1422,7 @@ void rpng_chunk_write(const char *filename, rpng_chunk chunk)
 //   Comment          Miscellaneous comment
 void rpng_chunk_write_text(const char *filename, char *keyword, char *text)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -827,7 +1445,7 @@ void rpng_chunk_write_text(const char *filename, char *keyword, char *text)
         char *file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
 
         // Verify expected output size before writing to file
-        if (file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
+        if ((size_t)file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
         else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
 
         RPNG_FREE(chunk.data);
@@ -843,7 +1461,7 @@ void rpng_chunk_write_text(const char *filename, char *keyword, char *text)
 //    unsigned char *comp_text;         // Compressed text: n bytes
 void rpng_chunk_write_comp_text(const char *filename, char *keyword, char *text)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -854,31 +1472,46 @@ void rpng_chunk_write_comp_text(const char *filename, char *keyword, char *text)
         int keyword_len = (int)strlen(keyword);
         int text_len = (int)strlen(text);
 
-        // Compress filtered image data and generate a valid zlib stream
-        struct sdefl *sde = (struct sdefl *)RPNG_CALLOC(sizeof(struct sdefl), 1);
-        int bounds = sdefl_bound(text_len);
-        unsigned char *comp_text = (unsigned char *)RPNG_CALLOC(bounds, 1);
-        int comp_text_size = zsdeflate(sde, comp_text, (unsigned char *)text, text_len, RPNG_COMPRESSION_LEVEL);
-        RPNG_FREE(sde);
+        // Compress text and generate a valid zlib stream
+        int bounds = rpng_compress_bound(text_len);
+        unsigned char *comp_text = (bounds > 0)? (unsigned char *)RPNG_CALLOC(bounds, 1) : NULL;
+        int comp_text_size = 0;
+
+        if (comp_text != NULL)
+        {
+            if (rpng_codec_custom.compress != NULL) comp_text_size = rpng_codec_custom.compress(rpng_codec_custom.user_data, (char *)comp_text, bounds, text, text_len, RPNG_COMPRESSION_LEVEL);
+            else
+            {
+                struct sdefl *sde = rpng_deflate_create(NULL, 0, text_len);
+                if (sde != NULL) comp_text_size = zsdeflate(sde, comp_text, (unsigned char *)text, text_len, RPNG_COMPRESSION_LEVEL);
+                sdefl_destroy(sde);
+            }
+        }
 
         // Fill chunk with required data
         // NOTE: CRC can be left to 0, it's calculated internally on writing
         memcpy(chunk.type, "zTXt", 4);
         chunk.length = keyword_len + 1 + 1 + comp_text_size;
-        chunk.data = (char *)RPNG_CALLOC(chunk.length, 1);
-        memcpy(chunk.data, keyword, keyword_len);
-        memcpy(chunk.data + keyword_len + 2, comp_text, comp_text_size);
+        if ((comp_text_size > 0) && (comp_text_size <= bounds)) chunk.data = (char *)RPNG_CALLOC(chunk.length, 1);
 
-        int file_output_size = 0;
-        char *file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
+        if (chunk.data != NULL)
+        {
+            memcpy(chunk.data, keyword, keyword_len);
+            memcpy(chunk.data + keyword_len + 2, comp_text, comp_text_size);
 
-        // Verify expected output size before writing to file
-        if (file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
-        else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
+            int file_output_size = 0;
+            char *file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
+
+            // Verify expected output size before writing to file
+            if ((size_t)file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
+            else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
+
+            RPNG_FREE(file_output);
+        }
+        else RPNG_LOG("WARNING: Text compression failed, zTXt chunk not written\n");
 
         RPNG_FREE(chunk.data);
         RPNG_FREE(comp_text);
-        RPNG_FREE(file_output);
         RPNG_FREE(file_data);
     }
 }
@@ -887,7 +1520,7 @@ void rpng_chunk_write_comp_text(const char *filename, char *keyword, char *text)
 // NOTE: Gamma is stored as one int: gamma*100000
 void rpng_chunk_write_gamma(const char *filename, float gamma)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -909,7 +1542,7 @@ void rpng_chunk_write_gamma(const char *filename, float gamma)
         char *file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
 
         // Verify expected output size before writing to file
-        if (file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
+        if ((size_t)file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
         else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
 
         RPNG_FREE(chunk.data);
@@ -926,7 +1559,7 @@ void rpng_chunk_write_gamma(const char *filename, float gamma)
 //   3: Absolute colorimetric
 void rpng_chunk_write_srgb(const char *filename, char srgb_type)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     rpng_chunk chunk = { 0 };
@@ -945,7 +1578,7 @@ void rpng_chunk_write_srgb(const char *filename, char srgb_type)
     char *file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
 
     // Verify expected output size before writing to file
-    if (file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
+    if ((size_t)file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
     else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
 
     RPNG_FREE(chunk.data);
@@ -963,7 +1596,7 @@ void rpng_chunk_write_srgb(const char *filename, char srgb_type)
 //   unsigned char second;        // 0 to 60 (yes, 60, for leap seconds; not 61, a common error)
 void rpng_chunk_write_time(const char *filename, short year, char month, char day, char hour, char min, char sec)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     rpng_chunk chunk = { 0 };
@@ -985,7 +1618,7 @@ void rpng_chunk_write_time(const char *filename, short year, char month, char da
     char *file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
 
     // Verify expected output size before writing to file
-    if (file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
+    if ((size_t)file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
     else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
 
     RPNG_FREE(chunk.data);
@@ -1000,7 +1633,7 @@ void rpng_chunk_write_time(const char *filename, short year, char month, char da
 //   unsigned char unit_specifier;       // 0 - Unit unknown, 1 - Unit is meter
 void rpng_chunk_write_physical_size(const char *filename, int pixels_unit_x, int pixels_unit_y, bool meters)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     rpng_chunk chunk = { 0 };
@@ -1022,7 +1655,7 @@ void rpng_chunk_write_physical_size(const char *filename, int pixels_unit_x, int
     char *file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
 
     // Verify expected output size before writing to file
-    if (file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
+    if ((size_t)file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
     else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
 
     RPNG_FREE(chunk.data);
@@ -1043,7 +1676,7 @@ void rpng_chunk_write_physical_size(const char *filename, int pixels_unit_x, int
 // NOTE: Each value is stored as one int: value*100000
 void rpng_chunk_write_chroma(const char *filename, float white_x, float white_y, float red_x, float red_y, float green_x, float green_y, float blue_x, float blue_y)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     rpng_chunk chunk = { 0 };
@@ -1075,7 +1708,7 @@ void rpng_chunk_write_chroma(const char *filename, float white_x, float white_y,
     char *file_output = rpng_chunk_write_from_memory(file_data, chunk, &file_output_size);
 
     // Verify expected output size before writing to file
-    if (file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
+    if ((size_t)file_output_size == (file_size + chunk.length + 12)) save_file_from_buffer(filename, file_output, file_output_size);
     else RPNG_LOG("WARNING: Failed to save file, output size not matching expected size\n");
 
     RPNG_FREE(chunk.data);
@@ -1113,39 +1746,72 @@ void rpng_chunk_print_info(const char *filename)
     RPNG_FREE(chunks);
 }
 
-// Check chunks CRC and order
+// Check chunks CRC is valid
 bool rpng_chunk_check_all_valid(const char *filename)
 {
-    bool result = true;
+    return (rpng_chunk_find_invalid(filename, NULL) == -1);
+}
 
-    int count = 0;
-    rpng_chunk *chunks = rpng_chunk_read_all(filename, &count);
-    if (chunks == NULL) return false;
+// Find first chunk with invalid CRC
+//  - Returns index of the first invalid chunk, -1 if all chunks are valid or -2 on error (file not readable, not a PNG)
+//  - Offset of the invalid chunk from file start is returned by reference (if provided), 0 if no invalid chunk
+// NOTE: File is read by blocks and CRC is computed incrementally, file is never fully loaded,
+// in case data is truncated before IEND, it's reported as invalid
+int rpng_chunk_find_invalid(const char *filename, size_t *offset)
+{
+    int result = -2;
+    size_t chunk_offset = 0;
 
-    unsigned int crc = 0;
-    char *chunk_type_data = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, 1);
+#if !defined(RPNG_NO_STDIO)
+    FILE *file = ((filename != NULL) && file_exists(filename))? fopen(filename, "rb") : NULL;
 
-    if (chunk_type_data != NULL)
+    if (file != NULL)
     {
-        for (int i = 0; i < count; i++)
+        unsigned char block[4096] = { 0 };
+
+        if ((fread(block, 1, 8, file) == 8) && (memcmp(block, png_signature, 8) == 0))  // Check valid PNG file
         {
-            memcpy(chunk_type_data, chunks[i].type, 4);
-            memcpy(chunk_type_data + 4, chunks[i].data, chunks[i].length);
-            crc = compute_crc32((unsigned char *)chunk_type_data, 4 + chunks[i].length);
-            crc = swap_endian(crc);
+            int counter = 0;
+            chunk_offset = 8;
 
-            // Check computed CRC matches provided CRC
-            if (chunks[i].crc != crc)
+            // Read chunk Length + FOURCC, data is read by blocks and CRC computed incrementally over type and data
+            while (fread(block, 1, 8, file) == 8)
             {
-                result = false;
-                break;
+                unsigned int chunk_size = swap_endian(((unsigned int *)block)[0]);
+                bool chunk_end = (memcmp(block + 4, "IEND", 4) == 0);
+                unsigned int crc = update_crc32(0, block + 4, 4);
+                unsigned int remain_size = chunk_size;
+
+                while (remain_size > 0)
+                {
+                    unsigned int read_size = (remain_size < sizeof(block))? remain_size : sizeof(block);
+                    if (fread(block, 1, read_size, file) != read_size) break;
+
+                    crc = update_crc32(crc, block, read_size);
+                    remain_size -= read_size;
+                }
+
+                // Check computed CRC matches provided CRC
+                if ((remain_size > 0) || (fread(block, 1, 4, file) != 4) || (swap_endian(((unsigned int *)block)[0]) != crc)) break;
+
+                counter++;
+                if (chunk_end) { counter = -1; break; }
+
+                chunk_offset += (4 + 4 + (size_t)chunk_size + 4);
             }
+
+            result = counter;   // WARNING: In case IEND chunk not reached, data is truncated
         }
+        else RPNG_LOG("WARNING: File not recognized as PNG\n");
+
+        fclose(file);
     }
+    else RPNG_LOG("FILEIO: File path provided is not valid\n");
+#else
+    (void)filename;
+#endif
 
-    // Free chunks memory
-    for (int i = 0; i < count; i++) RPNG_FREE(chunks[i].data);
-    RPNG_FREE(chunks);
+    if (offset != NULL) *offset = (result < 0)? 0 : chunk_offset;
 
     return result;
 }
@@ -1153,7 +1819,7 @@ bool rpng_chunk_check_all_valid(const char *filename)
 // Combine multiple IDAT chunks into a single one
 void rpng_chunk_combine_image_data(const char *filename)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -1162,7 +1828,7 @@ void rpng_chunk_combine_image_data(const char *filename)
         char *file_output = rpng_chunk_combine_image_data_from_memory(file_data, &file_output_size);
 
         // Verify process worked as expected
-        if ((file_output != NULL) && (file_output_size == file_size))
+        if ((file_output != NULL) && ((size_t)file_output_size == file_size))
         {
             save_file_from_buffer(filename, file_output, file_output_size);
         }
@@ -1175,7 +1841,7 @@ void rpng_chunk_combine_image_data(const char *filename)
 // Split one IDAT chunk into multiple ones
 void rpng_chunk_split_image_data(const char *filename, int split_size)
 {
-    int file_size = 0;
+    size_t file_size = 0;
     char *file_data = load_file_to_buffer(filename, &file_size);
 
     if (file_data != NULL)
@@ -1184,7 +1850,7 @@ void rpng_chunk_split_image_data(const char *filename, int split_size)
         char *file_output = rpng_chunk_split_image_data_from_memory(file_data, split_size, &file_output_size);
 
         // Verify process worked as expected
-        if ((file_output != 0) && (file_output_size > file_size))
+        if ((file_output != 0) && ((size_t)file_output_size > file_size))
         {
             save_file_from_buffer(filename, file_output, file_output_size);
         }
@@ -1199,74 +1865,36 @@ void rpng_chunk_split_image_data(const char *filename, int split_size)
 // Load png data from memory buffer
 char *rpng_load_image_from_memory(const char *buffer, int *width, int *height, int *color_channels, int *bit_depth)
 {
-    char *data = NULL;
-
-    rpng_chunk chunk_info = rpng_chunk_read_from_memory(buffer, "IHDR");
-
-    if (chunk_info.data == NULL) return data; // WARNING: Return if no info chunk has been loaded
-
-    // First chunk is always IHDR, we can check image data info
-    rpng_chunk_IHDR *IHDRData = (rpng_chunk_IHDR *)chunk_info.data;
-
-    *width = swap_endian(IHDRData->width);      // Image width
-    *height = swap_endian(IHDRData->height);    // Image height
-    *bit_depth = IHDRData->bit_depth;           // Bit depth
-
-    *color_channels = 0;
-    switch (IHDRData->color_type)
-    {
-        case 0: *color_channels = 1; break;     // Pixel format: 0-Grayscale
-        case 4: *color_channels = 2; break;     // Pixel format: 4-GrayAlpha
-        case 2: *color_channels = 3; break;     // Pixel format: 2-RGB
-        case 6: *color_channels = 4; break;     // Pixel format: 6-RGBA
-        case 3: *color_channels = 1; break;     // Pixel format: 3-Indexed (1 channel containing 8-bit indexed data)
-        default: break;
-    }
-
-    // TODO: Support bit depths of 1/2/4 bits? -> Convert to 8bit grayscale
-    if ((*color_channels == 1) && (*bit_depth != 8) && (*bit_depth != 16)) return data;  // Bit depth 1/2/4 not supported
-
-    // Additional info provided by IHDR (in case it was required)
-    //IHDRData->compression;        // Compression method: 0 (DEFLATE)
-    //IHDRData->filter;             // Filter method: 0 (default)
-    //IHDRData->interlace;          // Interlace scheme (optional): 0 (none)
-
-    if (*color_channels != 0)
-    {
-        // NOTE: All splitted chunks are joined on reading
-        rpng_chunk chunk_image = rpng_chunk_read_from_memory(buffer, "IDAT");
-
-        if (chunk_image.data != NULL)
-        {
-            // Verify data integrity CRC over all chunk data concatenated
-            unsigned int crc = 0;
-            char *chunk_type_data = (char *)RPNG_CALLOC(4 + chunk_image.length, 1);
-            memcpy(chunk_type_data, chunk_image.type, 4);
-            memcpy(chunk_type_data + 4, chunk_image.data, chunk_image.length);
-            crc = compute_crc32((unsigned char *)chunk_type_data, 4 + chunk_image.length);
-            RPNG_FREE(chunk_type_data);
-
-            if (crc == chunk_image.crc) // Validate crc
-            {
-                int pixel_size = *color_channels*(*bit_depth/8);
-                data = rpng_inflate_image_data(chunk_image.data, chunk_image.length, *width, *height, pixel_size);
+    return rpng_load_image_with_format_from_memory(buffer, width, height, color_channels, bit_depth, RPNG_OUTPUT_DEFAULT);
+}
 
-                if (data == NULL) RPNG_LOG("WARNING: IDAT image data decompression failed\n");
-            }
-            else RPNG_LOG("WARNING: CRC not valid, IDAT chunk image data could be corrupted\n");
-        }
+// Load png data from memory buffer converted to output format (RPNG_OUTPUT_* flags combination)
+// NOTE: Scanlines are converted once unfiltered, directly into the output size image data
+char *rpng_load_image_with_format_from_memory(const char *buffer, int *width, int *height, int *color_channels, int *bit_depth, int output_format)
+{
+    rpng_image image = { 0 };
+    rpng_load_image_data(NULL, buffer, output_format, &image);
 
-        RPNG_FREE(chunk_image.data);
-    }
-    else RPNG_LOG("WARNING: Failed to load file, image pixel format not supported\n");
+    *width = image.width;                   // Image width
+    *height = image.height;                 // Image height
+    *bit_depth = image.bit_depth;           // Bit depth
+    *color_channels = image.color_channels; // NOTE: Indexed returns 1 channel containing 8-bit indexed data
 
-    RPNG_FREE(chunk_info.data);
+    return image.data;
+}
 
-    return data;
+// Load multiple png images from memory buffers
+//  - Images are decoded concurrently if OpenMP is enabled, thread_count = 0 uses all available threads
+//  - Every image loading result is returned in image.result, RPNG_SUCCESS if loaded
+//  - Returns number of images loaded successfully
+int rpng_load_images_batch_from_memory(const char **buffers, int count, rpng_image *images, int thread_count)
+{
+    return rpng_load_images(buffers, false, count, images, thread_count);
 }
 
 // Load indexed png data (including palette) from memory buffer
 // NOTE: Returns indexed data as an index byte array (8bit) along the palette data (PLTE - RGB888 - 24bit)
+// NOTE: Indexed data with bit depth 1/2/4 is unpacked to 8 bit indexes
 char *rpng_load_image_indexed_from_memory(const char *buffer, int *width, int *height, rpng_palette *palette)
 {
     char *data = NULL;
@@ -1304,44 +1932,29 @@ char *rpng_load_image_indexed_from_memory(const char *buffer, int *width, int *h
         }
 
         // Load indexed image data
-        rpng_chunk chunk_info = rpng_chunk_read_from_memory(buffer, "IHDR");
+        rpng_chunk_IHDR image_info = { 0 };
 
-        // WARNING: Cast chunk_info data directly to expected IHDR struct layout
-        rpng_chunk_IHDR *IHDRData = (rpng_chunk_IHDR *)chunk_info.data;
-
-        *width = swap_endian(IHDRData->width);      // Image width
-        *height = swap_endian(IHDRData->height);    // Image height
-
-        // Verify color type is indexed (3) and bit depth is 8
-        if ((IHDRData->color_type == 3) && (IHDRData->bit_depth == 8))
+        if (rpng_read_image_info(buffer, &image_info))
         {
-            // NOTE: All splitted chunks are joined on reading
-            rpng_chunk chunk_image = rpng_chunk_read_from_memory(buffer, "IDAT");
+            *width = swap_endian(image_info.width);      // Image width
+            *height = swap_endian(image_info.height);    // Image height
 
-            if (chunk_image.data != NULL)
+            // Verify color type is indexed (3)
+            // NOTE: Bit depths 1/2/4 are unpacked to 8 bit indexes
+            if ((image_info.color_type == 3) && (image_info.bit_depth <= 8))
             {
-                // Verify data integrity CRC over all chunk data concatenated
-                unsigned int crc = 0;
-                char *chunk_type_data = (char *)RPNG_CALLOC(4 + chunk_image.length, 1);
-                memcpy(chunk_type_data, chunk_image.type, 4);
-                memcpy(chunk_type_data + 4, chunk_image.data, chunk_image.length);
-                crc = compute_crc32((unsigned char *)chunk_type_data, 4 + chunk_image.length);
-                RPNG_FREE(chunk_type_data);
-
-                if (crc == chunk_image.crc) // Validate crc
-                {
-                    int pixel_size = (IHDRData->bit_depth/8); // NOTE: Assume 1 channel
-                    data = rpng_inflate_image_data(chunk_image.data, chunk_image.length, *width, *height, pixel_size);
+                size_t data_size = rpng_get_image_data_size(*width, *height, 8);
+
+                if (data_size > 0) data = (char *)RPNG_MALLOC(data_size);
 
-                    if (data == NULL) RPNG_LOG("WARNING: IDAT image data decompression failed\n");
+                if ((data != NULL) && !rpng_decode_image_data(NULL, buffer, &image_info, RPNG_OUTPUT_DEFAULT, image_info.interlace? rpng_store_row_interlaced : rpng_store_row, data))
+                {
+                    RPNG_LOG("WARNING: IDAT image data decompression failed\n");
+                    RPNG_FREE(data);
+                    data = NULL;
                 }
-                else RPNG_LOG("WARNING: CRC not valid, IDAT chunk image data could be corrupted\n");
             }
-
-            RPNG_FREE(chunk_image.data);
         }
-
-        RPNG_FREE(chunk_info.data);
     }
 
     return data;
@@ -1351,181 +1964,317 @@ char *rpng_load_image_indexed_from_memory(const char *buffer, int *width, int *h
 char *rpng_save_image_to_memory(const char *data, int width, int height, int color_channels, int bit_depth, int *output_size)
 {
     char *output_buffer = NULL;
-    int output_buffer_size = 0;
+    rpng_save_image_data_to_memory(NULL, data, width, height, color_channels, bit_depth, NULL, NULL, &output_buffer, output_size);
 
-    if ((bit_depth != 8) && (bit_depth != 16))
-    {
-        RPNG_LOG("WARNING: Requested bit depth (%i bit per channel) not supported\n", bit_depth);
-        return output_buffer;  // WARNING: Bit depth 1/2/4 not supported
-    }
+    return output_buffer;
+}
 
-    int color_type = -1;
-    if (color_channels == 1) color_type = 0;        // Grayscale
-    else if (color_channels == 2) color_type = 4;   // Gray + Alpha
-    else if (color_channels == 3) color_type = 2;   // RGB
-    else if (color_channels == 4) color_type = 6;   // RGBA
+// Save png data to memory buffer with saving options
+char *rpng_save_image_with_options_to_memory(const char *data, int width, int height, int color_channels, int bit_depth, rpng_save_options options, int *output_size)
+{
+    char *output_buffer = NULL;
+    rpng_save_image_data_to_memory(NULL, data, width, height, color_channels, bit_depth, NULL, &options, &output_buffer, output_size);
 
-    if (color_type == -1) return output_buffer;   // WARNING: Number of channels not supported
+    return output_buffer;
+}
 
-    rpng_chunk_IHDR image_info = { 0 };
-    image_info.width = swap_endian(width);
-    image_info.height = swap_endian(height);
-    image_info.bit_depth = (unsigned char)bit_depth;
-    image_info.color_type = (unsigned char)color_type;
+// Save png data into provided buffer
+//  - Output buffer capacity must fit rpng_save_bound() size, it is checked before compressing data
+//  - Returns PNG data size written, 0 if data could not be saved
+size_t rpng_save_image_to_buffer(const char *data, int width, int height, int color_channels, int bit_depth, char *output_buffer, size_t output_buffer_capacity)
+{
+    size_t output_size = 0;
 
-    // Image data pre-processing to append filter type byte to every scanline
-    int pixel_size = color_channels*(bit_depth/8);
-    int comp_data_size = 0;
-    char *comp_data = rpng_deflate_image_data(data, width*height*pixel_size, width, height, pixel_size, &comp_data_size, -1);
+    if (output_buffer == NULL) return output_size;
 
-    // Security check to verify compression worked
-    if ((comp_data != NULL) && (comp_data_size > 0))
-    {
-        output_buffer = (char *)RPNG_CALLOC(8 + 13 + 12 + (comp_data_size + 12) + 12, 1); // Signature + IHDR + IDAT + IEND
+    rpng_save_image_data(NULL, data, width, height, color_channels, bit_depth, NULL, NULL, NULL, output_buffer, output_buffer_capacity, &output_size);
 
-        // Write PNG signature
-        memcpy(output_buffer, png_signature, 8);
+    return output_size;
+}
 
-        // Write PNG chunk IHDR
-        unsigned int length_IHDR = 13;
-        length_IHDR = swap_endian(length_IHDR);
-        memcpy(output_buffer + 8, &length_IHDR, 4);
-        memcpy(output_buffer + 8 + 4, "IHDR", 4);
-        memcpy(output_buffer + 8 + 4 + 4, &image_info, 13);
-        unsigned int crc = compute_crc32((unsigned char *)output_buffer + 8 + 4, 4 + 13);
-        crc = swap_endian(crc);
-        memcpy(output_buffer + 8 + 8 + 13, &crc, 4);
-        output_buffer_size += (8 + 12 + 13);
-
-        // Write PNG chunk IDAT
-        unsigned int length_IDAT = comp_data_size;
-        length_IDAT = swap_endian(length_IDAT);
-        memcpy(output_buffer + output_buffer_size, &length_IDAT, 4);
-        memcpy(output_buffer + output_buffer_size + 4, "IDAT", 4);
-        memcpy(output_buffer + output_buffer_size + 8, comp_data, comp_data_size);
-        crc = compute_crc32((unsigned char *)output_buffer + output_buffer_size + 4, 4 + comp_data_size);
-        crc = swap_endian(crc);
-        memcpy(output_buffer + output_buffer_size + 8 + comp_data_size, &crc, 4);
-        output_buffer_size += (comp_data_size + 12);
+// Get maximum PNG data size for image saving, useful to provide output buffer to rpng_save_image*_to_buffer()
+//  - Bound includes space for maximum palette chunks, so it is valid for indexed images: 1 color channel, 8 bit
+//  - Bound is valid for any saving options (interlaced data included)
+//  - Returns 0 if image is too big to be saved
+size_t rpng_save_bound(int width, int height, int color_channels, int bit_depth)
+{
+    size_t bound = 0;
 
-        // Write PNG chunk IEND
-        unsigned char chunk_IEND[12] = { 0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82 };
-        memcpy(output_buffer + output_buffer_size, chunk_IEND, 12);
-        output_buffer_size += 12;
-    }
+    // NOTE: Interlaced filtered data is bigger (filter type byte per pass scanline), so bound is valid for both
+    size_t filtered_data_size = rpng_get_filtered_data_size(width, height, color_channels*bit_depth, true);
 
-    RPNG_FREE(comp_data);
+    // WARNING: Compressor sizes are int, data size is checked to avoid overflows
+    if ((filtered_data_size > 0) && (filtered_data_size <= RPNG_MAX_DEFLATE_SIZE))
+    {
+        int comp_bound = rpng_compress_bound((int)filtered_data_size);
+        if (comp_bound > 0) bound = RPNG_MAX_HEADER_SIZE + comp_bound + 16;
+    }
 
-    *output_size = output_buffer_size;
-    return output_buffer;
+    return bound;
 }
 
-// Save indexed png data to memory buffer
-char *rpng_save_image_indexed_to_memory(const char *indexed_data, int width, int height, rpng_palette palette, int *output_size)
+// Set compression codec used for image data and compressed text chunks, NULL restores internal sdefl/sinfl
+// NOTE: Compression functions are only used if both compress_bound() and compress() are provided,
+// streaming functions are only used along their codec compress()/decompress() functions
+void rpng_set_codec(const rpng_codec *codec)
 {
-    char *output_buffer = NULL;
-    int output_buffer_size = 0;
+    memset(&rpng_codec_custom, 0, sizeof(rpng_codec));
 
-    rpng_chunk_IHDR image_info = { 0 };
-    image_info.width = swap_endian(width);
-    image_info.height = swap_endian(height);
-    image_info.bit_depth = 8;  // WARNING: Indexed data assumes 8-bit indexes
-    image_info.color_type = 3; // NOTE: Indexed data requires 3
+    if (codec == NULL) return;
 
-    // Image data pre-processing to append filter type byte to every scanline
-    int pixel_size = 1; // 1 byte per pixel (indexed data)
-    int comp_data_size = 0;
-    char *comp_data = rpng_deflate_image_data(indexed_data, width*height*pixel_size, width, height, pixel_size, &comp_data_size, 0);
+    rpng_codec_custom = *codec;
 
-    // Security check to verify compression worked
-    if ((comp_data != NULL) && (comp_data_size > 0))
+    if ((codec->compress == NULL) || (codec->compress_bound == NULL))
     {
-        // Verify if tRNS chunk with palette alpha values is required (if there is any alpha != 255)
-        bool trns_required = false;
-        for (int i = 0; i < palette.color_count; i++)
-        {
-            if (palette.colors[i].a != 255) { trns_required = true; break; }
-        }
+        if ((codec->compress != NULL) || (codec->compress_bound != NULL)) RPNG_LOG("WARNING: Codec compression requires compress_bound() and compress(), internal compressor used\n");
 
-        // Allocate output buffer at required size
-        output_buffer = (char *)RPNG_CALLOC(8 + ( 4 + 4 + 13 + 4) +  // Signature + IHDR
-            (4 + 4 + palette.color_count*3 + 4) +   // PLTE
-            (trns_required? (4 + 4 + palette.color_count + 4) : 0) + // tRNS
-            (4 + 4 + comp_data_size + 4) + 12, 1);  // IDAT + IEND
+        rpng_codec_custom.compress_bound = NULL;
+        rpng_codec_custom.compress = NULL;
+    }
 
-        // Write PNG signature
-        memcpy(output_buffer, png_signature, 8);
+    // Streaming compression requires all its functions
+    if ((rpng_codec_custom.compress == NULL) || (codec->compress_begin == NULL) || (codec->compress_write == NULL) || (codec->compress_end == NULL))
+    {
+        rpng_codec_custom.compress_begin = NULL;
+        rpng_codec_custom.compress_write = NULL;
+        rpng_codec_custom.compress_end = NULL;
+    }
 
-        // Write PNG chunk IHDR
-        unsigned int length_IHDR = 13;
-        length_IHDR = swap_endian(length_IHDR);
-        memcpy(output_buffer + 8, &length_IHDR, 4);
-        memcpy(output_buffer + 8 + 4, "IHDR", 4);
-        memcpy(output_buffer + 8 + 8, &image_info, 13);
-        unsigned int crc = compute_crc32((unsigned char *)output_buffer + 8 + 4, 4 + 13);
-        crc = swap_endian(crc);
-        memcpy(output_buffer + 8 + 8 + 13, &crc, 4);
-        output_buffer_size += (8 + 12 + 13);
-
-        // Write PNG chunk PLTE (palette)
-        unsigned int length_PLTE = palette.color_count*3;
-        length_PLTE = swap_endian(length_PLTE);
-        memcpy(output_buffer + output_buffer_size, &length_PLTE, 4);
-        memcpy(output_buffer + output_buffer_size + 4, "PLTE", 4);
-        char *plte_data = (char *)RPNG_CALLOC(palette.color_count*3, sizeof(char));
-        for (int i = 0; i < palette.color_count; i++)
-        {
-            plte_data[i*3 + 0] = palette.colors[i].r;
-            plte_data[i*3 + 1] = palette.colors[i].g;
-            plte_data[i*3 + 2] = palette.colors[i].b;
-        }
-        memcpy(output_buffer + output_buffer_size + 8, plte_data, palette.color_count*3);
-        RPNG_FREE(plte_data);
-        crc = compute_crc32((unsigned char *)output_buffer + output_buffer_size + 4, 4 + palette.color_count*3);
-        crc = swap_endian(crc);
-        memcpy(output_buffer + output_buffer_size + 8 + palette.color_count*3, &crc, 4);
-        output_buffer_size += (palette.color_count*3 + 12);
+    if (codec->decompress == NULL) rpng_codec_custom.decompress_stream = NULL;
+}
 
-        // Write PNG chunk tRNS (palette alpha values, if required)
-        if (trns_required)
+// Save multiple png images to memory buffers, output buffers are returned in input order
+//  - Images are compressed concurrently if OpenMP is enabled, thread_count = 0 uses all available threads
+//  - Every image saving result is returned in image.result, RPNG_SUCCESS if saved
+//  - Returns number of images saved successfully
+int rpng_save_images_batch_to_memory(rpng_image *images, int count, char **outputs, int *output_sizes, int thread_count)
+{
+    if (outputs == NULL) return 0;
+
+    return rpng_save_images(NULL, images, count, outputs, output_sizes, NULL, NULL, thread_count);
+}
+
+// Save multiple png images to memory, every output is provided to callback as soon as it is compressed
+//  - Callback calls are serialized between threads but images can be completed in any order
+//  - Output data is freed after callback returns
+//  - Returns number of images saved successfully
+int rpng_save_images_batch_to_callback(rpng_image *images, int count, rpng_save_callback callback, void *user_data, int thread_count)
+{
+    if (callback == NULL) return 0;
+
+    return rpng_save_images(NULL, images, count, NULL, NULL, callback, user_data, thread_count);
+}
+
+// Begin image saving by rows, PNG signature and IHDR chunk are written to callback
+rpng_encoder *rpng_encoder_begin(int width, int height, int color_channels, int bit_depth, rpng_write_callback callback, void *user_data)
+{
+    rpng_encoder *encoder = NULL;
+    int color_type = rpng_get_color_type(color_channels);
+
+    if ((callback == NULL) || (width <= 0) || (height <= 0)) return encoder;
+    if (((bit_depth != 8) && (bit_depth != 16)) || (color_type == -1))
+    {
+        RPNG_LOG("WARNING: Requested pixel format not supported\n");
+        return encoder;  // WARNING: Bit depth 1/2/4 not supported
+    }
+
+    // WARNING: Scanlines are compressed one by one, only scanline size must fit compressor int sizes
+    size_t row_size = rpng_get_image_data_size(width, 1, color_channels*bit_depth);
+    if ((row_size == 0) || (row_size >= RPNG_MAX_DEFLATE_SIZE))
+    {
+        RPNG_LOG("WARNING: Image width too big to be compressed\n");
+        return encoder;
+    }
+
+    // Custom codec without streaming compression requires all filtered image data, compressed at once
+    bool internal_codec = (rpng_codec_custom.compress == NULL);
+    bool codec_streaming = (rpng_codec_custom.compress_begin != NULL);
+    size_t filtered_data_size = rpng_get_filtered_data_size(width, height, color_channels*bit_depth, false);
+    if (!internal_codec && !codec_streaming && ((filtered_data_size == 0) || (filtered_data_size > RPNG_MAX_DEFLATE_SIZE)))
+    {
+        RPNG_LOG("WARNING: Image data too big to be compressed at once by codec\n");
+        return encoder;
+    }
+
+    encoder = (rpng_encoder *)RPNG_CALLOC(1, sizeof(rpng_encoder));
+    if (encoder == NULL) return encoder;
+
+    encoder->width = width;
+    encoder->height = height;
+    encoder->pixel_size = color_channels*(bit_depth/8);
+    encoder->row_size = (int)row_size;
+    encoder->callback = callback;
+    encoder->user_data = user_data;
+    encoder->row_previous = (unsigned char *)RPNG_MALLOC(row_size);
+    encoder->row_filtered = (unsigned char *)RPNG_MALLOC(row_size + 1);
+    encoder->chunk = (unsigned char *)RPNG_MALLOC(8 + RPNG_IDAT_CHUNK_SIZE + 4);
+
+    if (internal_codec)
+    {
+        encoder->sde = rpng_deflate_create(NULL, 0, (row_size + 1)*height);
+        encoder->stream = (struct sdefl_stream *)RPNG_CALLOC(1, sizeof(struct sdefl_stream));
+    }
+    else if (!codec_streaming) encoder->data_filtered = (unsigned char *)RPNG_MALLOC(filtered_data_size);
+
+    if ((encoder->row_previous == NULL) || (encoder->row_filtered == NULL) || (encoder->chunk == NULL) ||
+        (internal_codec && ((encoder->sde == NULL) || (encoder->stream == NULL))) ||
+        (!internal_codec && !codec_streaming && (encoder->data_filtered == NULL)))
+    {
+        rpng_encoder_close(encoder);
+        return NULL;
+    }
+
+    // Write PNG signature and IHDR chunk
+    rpng_chunk_IHDR image_info = { 0 };
+    image_info.width = swap_endian(width);
+    image_info.height = swap_endian(height);
+    image_info.bit_depth = (unsigned char)bit_depth;
+    image_info.color_type = (unsigned char)color_type;
+
+    unsigned char header[8 + 12 + 13] = { 0 };
+    unsigned int length_IHDR = swap_endian(13);
+    memcpy(header, png_signature, 8);
+    memcpy(header + 8, &length_IHDR, 4);
+    memcpy(header + 8 + 4, "IHDR", 4);
+    memcpy(header + 8 + 4 + 4, &image_info, 13);
+    unsigned int crc = swap_endian(compute_crc32(header + 8 + 4, 4 + 13));
+    memcpy(header + 8 + 8 + 13, &crc, 4);
+
+    bool stream_ready = callback(user_data, (const char *)header, 8 + 12 + 13);
+
+    if (stream_ready && internal_codec) stream_ready = (zsdeflate_begin(encoder->sde, encoder->stream, RPNG_COMPRESSION_LEVEL, rpng_encoder_write, encoder) == 0);
+    else if (stream_ready && codec_streaming)
+    {
+        encoder->codec_stream = rpng_codec_custom.compress_begin(rpng_codec_custom.user_data, RPNG_COMPRESSION_LEVEL, rpng_encoder_write_codec, encoder);
+        stream_ready = (encoder->codec_stream != NULL);
+    }
+
+    if (!stream_ready)
+    {
+        rpng_encoder_close(encoder);
+        return NULL;
+    }
+
+    return encoder;
+}
+
+// Push image rows to encoder, every row is filtered and compressed
+//  - Returns false if rows exceed image height or data could not be written
+bool rpng_encoder_push_rows(rpng_encoder *encoder, const char *rows_data, int rows_count)
+{
+    if ((encoder == NULL) || encoder->failed || (rows_data == NULL) || (rows_count < 0)) return false;
+    if (rows_count > (encoder->height - encoder->row))
+    {
+        RPNG_LOG("WARNING: Image rows provided exceed image height\n");
+        return false;
+    }
+
+    const unsigned char *row = NULL;
+
+    for (int i = 0; i < rows_count; i++)
+    {
+        row = (const unsigned char *)rows_data + (size_t)encoder->row_size*i;
+
+        // Previous scanline is available from provided rows or kept from previous push
+        const unsigned char *previous = NULL;
+        if (i > 0) previous = row - encoder->row_size;
+        else if (encoder->row > 0) previous = encoder->row_previous;
+
+        // NOTE: Without streaming compression, scanlines are filtered in place into image data filtered
+        unsigned char *row_filtered = encoder->row_filtered;
+        if (encoder->data_filtered != NULL) row_filtered = encoder->data_filtered + (size_t)encoder->row*(encoder->row_size + 1);
+
+        rpng_filter_row(row_filtered, row, previous, encoder->row_size, encoder->pixel_size, -1);
+
+        bool written = true;
+        if (encoder->stream != NULL) written = (zsdeflate_write(encoder->sde, encoder->stream, row_filtered, encoder->row_size + 1) == 0);
+        else if (encoder->codec_stream != NULL) written = rpng_codec_custom.compress_write(encoder->codec_stream, (const char *)row_filtered, encoder->row_size + 1);
+
+        if (!written)
         {
-            unsigned int length_tRNS = palette.color_count;
-            length_tRNS = swap_endian(length_tRNS);
-            memcpy(output_buffer + output_buffer_size, &length_tRNS, 4);
-            memcpy(output_buffer + output_buffer_size + 4, "tRNS", 4);
-            char *trns_data = (char *)RPNG_CALLOC(palette.color_count, sizeof(char));
-            for (int i = 0; i < palette.color_count; i++) trns_data[i] = palette.colors[i].a;
-            memcpy(output_buffer + output_buffer_size + 8, trns_data, palette.color_count);
-            RPNG_FREE(trns_data);
-            crc = compute_crc32((unsigned char *)output_buffer + output_buffer_size + 4, 4 + palette.color_count);
-            crc = swap_endian(crc);
-            memcpy(output_buffer + output_buffer_size + 8 + palette.color_count, &crc, 4);
-            output_buffer_size += (palette.color_count + 12);
-        }
-
-        // Write PNG chunk IDAT
-        unsigned int length_IDAT = comp_data_size;
-        length_IDAT = swap_endian(length_IDAT);
-        memcpy(output_buffer + output_buffer_size, &length_IDAT, 4);
-        memcpy(output_buffer + output_buffer_size + 4, "IDAT", 4);
-        memcpy(output_buffer + output_buffer_size + 8, comp_data, comp_data_size);
-        crc = compute_crc32((unsigned char *)output_buffer + output_buffer_size + 4, 4 + comp_data_size);
-        crc = swap_endian(crc);
-        memcpy(output_buffer + output_buffer_size + 8 + comp_data_size, &crc, 4);
-        output_buffer_size += (comp_data_size + 12);
+            RPNG_LOG("WARNING: Image data could not be written\n");
+            encoder->failed = true;
+            return false;
+        }
+
+        encoder->row++;
+    }
+
+    if (row != NULL) memcpy(encoder->row_previous, row, encoder->row_size);
+
+    return true;
+}
 
-        // Write PNG chunk IEND
+// End image saving, compressed data is flushed and IEND chunk is written, encoder is freed
+//  - Returns true if all image rows have been pushed and PNG data has been fully written
+bool rpng_encoder_end(rpng_encoder *encoder)
+{
+    if (encoder == NULL) return false;
+
+    bool result = !encoder->failed;
+
+    if (result && (encoder->row < encoder->height))
+    {
+        RPNG_LOG("WARNING: Image rows missing: %i/%i rows provided\n", encoder->row, encoder->height);
+        result = false;
+    }
+
+    if (result)
+    {
         unsigned char chunk_IEND[12] = { 0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82 };
-        memcpy(output_buffer + output_buffer_size, chunk_IEND, 12);
-        output_buffer_size += 12;
+
+        if (encoder->stream != NULL) result = (zsdeflate_end(encoder->sde, encoder->stream) == 0);
+        else if (encoder->codec_stream != NULL)
+        {
+            result = rpng_codec_custom.compress_end(encoder->codec_stream, true);
+            encoder->codec_stream = NULL;
+        }
+        else
+        {
+            // Image data filtered compressed at once, zlib stream written as IDAT chunks
+            int data_size = (int)((size_t)(encoder->row_size + 1)*encoder->height);
+            int comp_capacity = rpng_compress_bound(data_size);
+            char *comp_data = (comp_capacity > 0)? (char *)RPNG_MALLOC(comp_capacity) : NULL;
+            int comp_size = 0;
+
+            if (comp_data != NULL) comp_size = rpng_codec_custom.compress(rpng_codec_custom.user_data, comp_data, comp_capacity, (const char *)encoder->data_filtered, data_size, RPNG_COMPRESSION_LEVEL);
+
+            result = (comp_size > 0) && (rpng_encoder_write(encoder, (const unsigned char *)comp_data, comp_size) == 0);
+            RPNG_FREE(comp_data);
+        }
+
+        result = result && ((encoder->chunk_fill == 0) || rpng_encoder_write_chunk(encoder)) &&
+                 encoder->callback(encoder->user_data, (const char *)chunk_IEND, 12);
     }
 
-    RPNG_FREE(comp_data);
+    rpng_encoder_close(encoder);
+
+    return result;
+}
+
+// Save indexed png data to memory buffer
+char *rpng_save_image_indexed_to_memory(const char *indexed_data, int width, int height, rpng_palette palette, int *output_size)
+{
+    char *output_buffer = NULL;
+    rpng_save_image_data_to_memory(NULL, indexed_data, width, height, 1, 8, &palette, NULL, &output_buffer, output_size);
 
-    *output_size = output_buffer_size;
     return output_buffer;
 }
 
+// Save indexed png data into provided buffer
+//  - Output buffer capacity must fit rpng_save_bound(width, height, 1, 8) size
+//  - Returns PNG data size written, 0 if data could not be saved
+size_t rpng_save_image_indexed_to_buffer(const char *indexed_data, int width, int height, rpng_palette palette, char *output_buffer, size_t output_buffer_capacity)
+{
+    size_t output_size = 0;
+
+    if (output_buffer == NULL) return output_size;
+
+    rpng_save_image_data(NULL, indexed_data, width, height, 1, 8, &palette, NULL, NULL, output_buffer, output_buffer_capacity, &output_size);
+
+    return output_size;
+}
+
 // Convert indexed image data to RGBA data
 char *rpng_unindex_image_data(char *indexed_data, int width, int height, rpng_palette palette)
 {
@@ -1533,18 +2282,149 @@ char *rpng_unindex_image_data(char *indexed_data, int width, int height, rpng_pa
 
     if ((indexed_data != NULL) && (palette.color_count > 0) && (palette.colors != NULL))
     {
-        data = (char *)RPNG_CALLOC(width*height*4, sizeof(char));
+        // NOTE: Indexes are expanded with palette colors lookup table, every index out of palette range is expanded as opaque black
+        unsigned int lut[256] = { 0 };
+        rpng_get_palette_lut(lut, palette.colors, palette.color_count, RPNG_OUTPUT_RGBA);
+
+        size_t data_size = rpng_get_image_data_size(width, height, 32);
+        if (data_size > 0) data = (char *)RPNG_MALLOC(data_size);
+
+        for (int y = 0; (data != NULL) && (y < height); y++)
+        {
+            rpng_expand_row((unsigned char *)data + (size_t)y*width*4, (const unsigned char *)indexed_data + (size_t)y*width, width, lut);
+        }
+    }
+    else RPNG_LOG("Provided indexed data or palette not valid, data can not be un-indexed\n");
+
+    return data;
+}
+
+// Verify png data integrity from memory buffer
+// NOTE: Image data is decompressed and unfiltered scanline by scanline but not stored,
+// if image data is splitted in multiple IDAT chunks, compressed data is concatenated
+bool rpng_verify_from_memory(const char *buffer)
+{
+    bool result = false;
+
+    size_t invalid_offset = 0;
+    int invalid_chunk = rpng_chunk_find_invalid_from_memory(buffer, &invalid_offset);
+
+    if (invalid_chunk == -1)
+    {
+        rpng_chunk_IHDR image_info = { 0 };
 
-        for (int i = 0; i < width*height; i++)
+        if (!rpng_read_image_info(buffer, &image_info)) RPNG_LOG("WARNING: IHDR chunk image info not valid\n");
+        else if ((image_info.color_type == 3) && (rpng_find_chunk(buffer, "PLTE") == NULL)) RPNG_LOG("WARNING: PLTE chunk not found, required for indexed image\n");
+        else
         {
-            data[i*4 + 0] = palette.colors[(int)indexed_data[i]].r;
-            data[i*4 + 1] = palette.colors[(int)indexed_data[i]].g;
-            data[i*4 + 2] = palette.colors[(int)indexed_data[i]].b;
-            data[i*4 + 3] = palette.colors[(int)indexed_data[i]].a;
+            // Decode all scanlines, no rows processor required
+            result = rpng_decode_image_data(NULL, buffer, &image_info, RPNG_OUTPUT_DEFAULT, NULL, NULL);
+
+            if (!result) RPNG_LOG("WARNING: IDAT image data could not be decoded\n");
         }
+    }
+    else if (invalid_chunk == -2) RPNG_LOG("WARNING: PNG chunks could not be validated\n");
+    else RPNG_LOG("WARNING: Chunk %i CRC not valid (offset: %zu)\n", invalid_chunk, invalid_offset);
+
+    return result;
+}
+
+// Load png data row by row from memory buffer
+// NOTE: Full image data is never stored, every row is provided to callback once decoded
+bool rpng_load_image_rows_from_memory(const char *buffer, int *width, int *height, int *color_channels, int *bit_depth, rpng_row_callback callback, void *user_data)
+{
+    bool result = false;
+    rpng_chunk_IHDR image_info = { 0 };
 
+    if ((callback != NULL) && rpng_read_image_info(buffer, &image_info))
+    {
+        *width = swap_endian(image_info.width);
+        *height = swap_endian(image_info.height);
+        *bit_depth = (image_info.bit_depth < 8)? 8 : image_info.bit_depth;   // NOTE: Bit depths 1/2/4 are unpacked to 8 bit
+        *color_channels = rpng_get_color_channels(image_info.color_type);
+
+        if (image_info.interlace != 0) RPNG_LOG("WARNING: Failed to load file, interlaced image data can not be loaded by rows\n");
+        else
+        {
+            rpng_row_callback_data callback_data = { callback, user_data };
+            result = rpng_decode_image_data(NULL, buffer, &image_info, RPNG_OUTPUT_DEFAULT, rpng_callback_row, &callback_data);
+        }
+    }
+
+    return result;
+}
+
+// Load png data progressively from memory buffer
+// NOTE: Image data is allocated initialized to 0, interlaced passes pixels are stored into their image positions
+char *rpng_load_image_progressive_from_memory(const char *buffer, int *width, int *height, int *color_channels, int *bit_depth, rpng_pass_callback callback, void *user_data)
+{
+    char *data = NULL;
+    rpng_chunk_IHDR image_info = { 0 };
+
+    if ((callback != NULL) && rpng_read_image_info(buffer, &image_info))
+    {
+        *width = swap_endian(image_info.width);
+        *height = swap_endian(image_info.height);
+        *bit_depth = (image_info.bit_depth < 8)? 8 : image_info.bit_depth;   // NOTE: Bit depths 1/2/4 are unpacked to 8 bit
+        *color_channels = rpng_get_color_channels(image_info.color_type);
+
+        size_t data_size = rpng_get_image_data_size(*width, *height, (*color_channels)*(*bit_depth));
+
+        if (data_size > 0) data = (char *)RPNG_CALLOC(data_size, 1);
+
+        if (data != NULL)
+        {
+            rpng_pass_callback_data callback_data = { data, callback, user_data };
+
+            if (!rpng_decode_image_data(NULL, buffer, &image_info, RPNG_OUTPUT_DEFAULT, rpng_progressive_row, &callback_data))
+            {
+                RPNG_LOG("WARNING: IDAT image data decompression failed or stopped\n");
+                RPNG_FREE(data);
+                data = NULL;
+            }
+        }
+    }
+
+    return data;
+}
+
+// Load png data region from memory buffer
+// NOTE: Scanlines above region are decoded (required for unfiltering) but not stored, decoding is stopped
+// once last region scanline is stored, for interlaced images only after it is completed by last pass
+char *rpng_load_image_region_from_memory(const char *buffer, int x, int y, int width, int height, int *color_channels, int *bit_depth)
+{
+    char *data = NULL;
+    rpng_chunk_IHDR image_info = { 0 };
+
+    if (rpng_read_image_info(buffer, &image_info))
+    {
+        int image_width = swap_endian(image_info.width);
+        int image_height = swap_endian(image_info.height);
+        rpng_get_output_format(&image_info, RPNG_OUTPUT_DEFAULT, color_channels, bit_depth);
+
+        if ((x < 0) || (y < 0) || (width <= 0) || (height <= 0) || (x > (image_width - width)) || (y > (image_height - height)))
+        {
+            RPNG_LOG("WARNING: Image region is out of image bounds\n");
+            return NULL;
+        }
+
+        size_t data_size = rpng_get_image_data_size(width, height, (*color_channels)*(*bit_depth));
+
+        if (data_size > 0) data = (char *)RPNG_MALLOC(data_size);
+
+        if (data != NULL)
+        {
+            rpng_region_data region = { data, x, y, width, height, false };
+
+            // NOTE: Decoding is stopped by rows processor once region is complete
+            if (!rpng_decode_image_data(NULL, buffer, &image_info, RPNG_OUTPUT_DEFAULT, rpng_store_region_row, &region) && !region.complete)
+            {
+                RPNG_LOG("WARNING: IDAT image data decompression failed\n");
+                RPNG_FREE(data);
+                data = NULL;
+            }
+        }
     }
-    else RPNG_LOG("Provided indexed data or palette not valid, data can not be un-indexed\n");
 
     return data;
 }
@@ -1595,36 +2475,48 @@ rpng_chunk rpng_chunk_read_from_memory(const char *buffer, const char *chunk_typ
         // In case chunk(s) requested is IDAT, all IDAT chunks are concatenated
         if (memcmp(chunk_type, "IDAT", 4) == 0)
         {
-            char *idat_data_concat = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, sizeof(char));
-            int idat_data_concat_size = 0;
+            size_t idat_data_concat_size = 0;
 
+            // Compute all IDAT chunks data size to allocate it at once
             while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
             {
-                if (memcmp(buffer_ptr + 4, chunk_type, 4) == 0) // Check next IDAT chunk
-                {
-                    memcpy(idat_data_concat + idat_data_concat_size, (char *)(buffer_ptr + 8), chunk_size);
-                    idat_data_concat_size += chunk_size;
-
-                    // TODO: Validate every IDAT chunk CRC32
-                }
+                if (memcmp(buffer_ptr + 4, chunk_type, 4) == 0) idat_data_concat_size += chunk_size;
 
                 buffer_ptr += (4 + 4 + chunk_size + 4); // Move pointer to next chunk of input data
                 chunk_size = swap_endian(((int *)buffer_ptr)[0]); // Compute next chunk file_size
             }
 
-            // Fill chunk data with all accumulated IDAT
-            chunk.length = idat_data_concat_size;
-            memcpy(chunk.type, "IDAT", 4);
-            chunk.data = (char *)RPNG_CALLOC(idat_data_concat_size, sizeof(char));
-            memcpy(chunk.data, idat_data_concat, idat_data_concat_size);
-            RPNG_FREE(idat_data_concat);
+            // NOTE: Chunk length is an int, concatenated IDAT data can not be returned over 2GB
+            if (idat_data_concat_size > 0x7fffffff) RPNG_LOG("WARNING: IDAT chunks data too big to be concatenated into one chunk\n");
+            else
+            {
+                // Fill chunk data with all accumulated IDAT
+                chunk.length = (int)idat_data_concat_size;
+                memcpy(chunk.type, "IDAT", 4);
+                chunk.data = (char *)RPNG_MALLOC(idat_data_concat_size);
+                chunk.crc = update_crc32(0, (const unsigned char *)chunk.type, 4);  // CRC32 computed for security
+                idat_data_concat_size = 0;
+
+                buffer_ptr = (char *)buffer + 8;
+                chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+                while ((chunk.data != NULL) && (memcmp(buffer_ptr + 4, "IEND", 4) != 0)) // While IEND chunk not reached
+                {
+                    if (memcmp(buffer_ptr + 4, chunk_type, 4) == 0) // Check next IDAT chunk
+                    {
+                        memcpy(chunk.data + idat_data_concat_size, (char *)(buffer_ptr + 8), chunk_size);
+                        chunk.crc = update_crc32(chunk.crc, (const unsigned char *)buffer_ptr + 8, chunk_size);
+                        idat_data_concat_size += chunk_size;
+
+                        // TODO: Validate every IDAT chunk CRC32
+                    }
+
+                    buffer_ptr += (4 + 4 + chunk_size + 4); // Move pointer to next chunk of input data
+                    chunk_size = swap_endian(((int *)buffer_ptr)[0]); // Compute next chunk file_size
+                }
 
-            // Compute CRC32 for security
-            unsigned char *chunk_type_data = (unsigned char *)RPNG_CALLOC(4 + chunk.length, 1);
-            memcpy(chunk_type_data, chunk.type, 4);
-            memcpy(chunk_type_data + 4, chunk.data, chunk.length);
-            chunk.crc = compute_crc32(chunk_type_data, 4 + chunk.length);
-            RPNG_FREE(chunk_type_data);
+                if (chunk.data == NULL) chunk.length = 0;
+            }
         }
         else // Only one chunk required, not IDAT type
         {
@@ -1702,41 +2594,20 @@ rpng_chunk *rpng_chunk_read_all_from_memory(const char *buffer, int *count)
 // NOTE: returns output_data and output_size through parameter
 char *rpng_chunk_remove_from_memory(const char *buffer, const char *chunk_type, int *output_size)
 {
-    char *buffer_ptr = (char *)buffer;
     char *output_buffer = NULL;
     int output_buffer_size = 0;
+    size_t required_size = rpng_chunk_remove_to_buffer(buffer, chunk_type, NULL, 0);
 
-    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0))  // Check valid PNG file
+    // WARNING: Output size must fit in an int, use rpng_chunk_remove_to_buffer() for bigger files
+    if ((required_size > 0) && (required_size <= 0x7fffffff))
     {
-        output_buffer = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, 1);  // Output buffer allocation
-
-        memcpy(output_buffer, png_signature, 8);        // Copy PNG signature
-        output_buffer_size += 8;
+        output_buffer = (char *)RPNG_MALLOC(required_size);  // Output buffer allocation, exact size
 
-        buffer_ptr += 8;       // Move pointer after signature
-
-        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
-
-        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
+        if (output_buffer != NULL)
         {
-            // If chunk type is not the requested, just copy input data into output buffer
-            if (memcmp(buffer_ptr + 4, chunk_type, 4) != 0)
-            {
-                memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
-                output_buffer_size += (4 + 4 + chunk_size + 4);
-            }
-
-            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
-            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+            rpng_chunk_remove_to_buffer(buffer, chunk_type, output_buffer, required_size);
+            output_buffer_size = (int)required_size;
         }
-
-        // Write IEND chunk
-        memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + 4);
-        output_buffer_size += 12;
-
-        // Resize output buffer
-        char *output_buffer_sized = (char *)RPNG_REALLOC(output_buffer, output_buffer_size);
-        if (output_buffer_sized != NULL) output_buffer = output_buffer_sized;
     }
 
     *output_size = output_buffer_size;
@@ -1747,47 +2618,20 @@ char *rpng_chunk_remove_from_memory(const char *buffer, const char *chunk_type,
 // NOTE: returns output_data and output_size through parameter
 char *rpng_chunk_remove_ancillary_from_memory(const char *buffer, int *output_size)
 {
-    char *buffer_ptr = (char *)buffer;
     char *output_buffer = NULL;
     int output_buffer_size = 0;
+    size_t required_size = rpng_chunk_remove_ancillary_to_buffer(buffer, NULL, 0);
 
-    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0))  // Check valid PNG file
+    // WARNING: Output size must fit in an int, use rpng_chunk_remove_ancillary_to_buffer() for bigger files
+    if ((required_size > 0) && (required_size <= 0x7fffffff))
     {
-        bool preserve_palette_transparency = false;
-
-        output_buffer = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, 1);  // Output buffer allocation
-
-        memcpy(output_buffer, png_signature, 8);        // Copy PNG signature
-        output_buffer_size += 8;
-        buffer_ptr += 8;       // Move pointer after signature
-
-        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        output_buffer = (char *)RPNG_MALLOC(required_size);  // Output buffer allocation, exact size
 
-        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
+        if (output_buffer != NULL)
         {
-            if (memcmp(buffer_ptr + 4, "PLTE", 4) == 0) preserve_palette_transparency = true;
-
-            // If chunk type is mandatory, just copy input data into output buffer
-            if ((memcmp(buffer_ptr + 4, "IHDR", 4) == 0) ||
-                (memcmp(buffer_ptr + 4, "PLTE", 4) == 0) ||
-                (memcmp(buffer_ptr + 4, "IDAT", 4) == 0) ||
-                (preserve_palette_transparency && (memcmp(buffer_ptr + 4, "tRNS", 4) == 0)))
-            {
-                memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
-                output_buffer_size += (4 + 4 + chunk_size + 4);
-            }
-
-            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
-            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+            rpng_chunk_remove_ancillary_to_buffer(buffer, output_buffer, required_size);
+            output_buffer_size = (int)required_size;
         }
-
-        // Write IEND chunk
-        memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + 4);
-        output_buffer_size += 12;
-
-        // Resize output buffer
-        char *output_buffer_sized = (char *)RPNG_REALLOC(output_buffer, output_buffer_size);
-        if (output_buffer_sized != NULL) output_buffer = output_buffer_sized;
     }
 
     *output_size = output_buffer_size;
@@ -1798,56 +2642,20 @@ char *rpng_chunk_remove_ancillary_from_memory(const char *buffer, int *output_si
 // NOTE: returns output data file_size
 char *rpng_chunk_write_from_memory(const char *buffer, rpng_chunk chunk, int *output_size)
 {
-    char *buffer_ptr = (char *)buffer;
     char *output_buffer = NULL;
     int output_buffer_size = 0;
+    size_t required_size = rpng_chunk_write_to_buffer(buffer, chunk, NULL, 0);
 
-    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0))  // Check valid PNG file
+    // WARNING: Output size must fit in an int, use rpng_chunk_write_to_buffer() for bigger files
+    if ((required_size > 0) && (required_size <= 0x7fffffff))
     {
-        output_buffer = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, 1);
-
-        memcpy(output_buffer, png_signature, 8);        // Copy PNG signature
-        output_buffer_size += 8;
-        buffer_ptr += 8;       // Move pointer after signature
-
-        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        output_buffer = (char *)RPNG_MALLOC(required_size);  // Output buffer allocation, exact size
 
-        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
+        if (output_buffer != NULL)
         {
-            memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
-            output_buffer_size += (4 + 4 + chunk_size + 4);
-
-            // Check if we just copied the IHDR chunk to append our chunk after it
-            if (memcmp(buffer_ptr + 4, "IHDR", 4) == 0)
-            {
-                int chunk_length_be = swap_endian(chunk.length);
-                memcpy(output_buffer + output_buffer_size, &chunk_length_be, sizeof(int));           // Write chunk length
-                memcpy(output_buffer + output_buffer_size + 4, chunk.type, 4);                // Write chunk type
-                memcpy(output_buffer + output_buffer_size + 4 + 4, chunk.data, chunk.length); // Write chunk data
-
-                unsigned char *type_data = (unsigned char *)RPNG_MALLOC(4 + chunk.length);
-                memcpy(type_data, chunk.type, 4);
-                memcpy(type_data + 4, chunk.data, chunk.length);
-                unsigned int crc = compute_crc32(type_data, 4 + chunk.length);
-                crc = swap_endian(crc);
-                memcpy(output_buffer + output_buffer_size + 4 + 4 + chunk.length, &crc, 4);   // Write CRC32 (computed over type + data)
-
-                RPNG_FREE(type_data);
-
-                output_buffer_size += (4 + 4 + chunk.length + 4);  // Update output file file_size with new chunk
-            }
-
-            buffer_ptr += (4 + 4 + chunk_size + 4);           // Move pointer to next chunk of input data
-            chunk_size = swap_endian(((int *)buffer_ptr)[0]);  // Compute next chunk file_size
+            rpng_chunk_write_to_buffer(buffer, chunk, output_buffer, required_size);
+            output_buffer_size = (int)required_size;
         }
-
-        // Write IEND chunk
-        memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + 4);
-        output_buffer_size += 12;
-
-        // Resize output buffer
-        char *output_buffer_sized = (char *)RPNG_REALLOC(output_buffer, output_buffer_size);
-        if (output_buffer_sized != NULL) output_buffer = output_buffer_sized;
     }
 
     *output_size = output_buffer_size;
@@ -1858,322 +2666,2341 @@ char *rpng_chunk_write_from_memory(const char *buffer, rpng_chunk chunk, int *ou
 // NOTE: Returns buffer with all concatenated IDAT chunks
 char *rpng_chunk_combine_image_data_from_memory(char *buffer, int *output_size)
 {
-    char *buffer_ptr = (char *)buffer;
     char *output_buffer = NULL;
     int output_buffer_size = 0;
+    size_t required_size = rpng_chunk_combine_image_data_to_buffer(buffer, NULL, 0);
 
-    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0)) // Check valid PNG file
+    // WARNING: Output size must fit in an int, use rpng_chunk_combine_image_data_to_buffer() for bigger files
+    if ((required_size > 0) && (required_size <= 0x7fffffff))
     {
-        char *idata_buffer = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, 1); // Output buffer allocation
-        memcpy(idata_buffer, "IDAT", 4);
-        int idata_buffer_size = 0;
-        output_buffer = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, 1); // Output buffer allocation
-
-        memcpy(output_buffer, png_signature, 8); // Copy PNG signature
-        output_buffer_size += 8;
-        buffer_ptr += 8; // Move pointer after signature
-
-        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        output_buffer = (char *)RPNG_MALLOC(required_size);  // Output buffer allocation, exact size
 
-        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0)         // While IEND chunk not reached
+        if (output_buffer != NULL)
         {
-            // If IDAT chunk just copy data into idata_buffer
-            if ((memcmp(buffer_ptr + 4, "IDAT", 4) == 0))
+            rpng_chunk_combine_image_data_to_buffer(buffer, output_buffer, required_size);
+            output_buffer_size = (int)required_size;
+        }
+    }
+
+    *output_size = output_buffer_size;
+    return output_buffer;
+}
+
+// Split one IDAT chunk into multiple ones
+char *rpng_chunk_split_image_data_from_memory(char *buffer, int split_size, int *output_size)
+{
+    char *output_buffer = NULL;
+    int output_buffer_size = 0;
+    size_t required_size = rpng_chunk_split_image_data_to_buffer(buffer, split_size, NULL, 0);
+
+    // WARNING: Output size must fit in an int, use rpng_chunk_split_image_data_to_buffer() for bigger files
+    if ((required_size > 0) && (required_size <= 0x7fffffff))
+    {
+        output_buffer = (char *)RPNG_MALLOC(required_size);  // Output buffer allocation, exact size
+
+        if (output_buffer != NULL)
+        {
+            rpng_chunk_split_image_data_to_buffer(buffer, split_size, output_buffer, required_size);
+            output_buffer_size = (int)required_size;
+        }
+    }
+
+    *output_size = output_buffer_size;
+    return output_buffer;
+}
+
+// Remove one chunk type from memory buffer into a provided output buffer
+// NOTE: Returns required output size, data is only written if output_buffer fits it
+size_t rpng_chunk_remove_to_buffer(const char *buffer, const char *chunk_type, char *output_buffer, size_t output_buffer_capacity)
+{
+    const char *buffer_ptr = buffer;
+    size_t output_buffer_size = 0;
+
+    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0))  // Check valid PNG file
+    {
+        // Compute required output size from chunks headers
+        output_buffer_size = 8 + 12;    // PNG signature + IEND chunk
+        buffer_ptr += 8;                // Move pointer after signature
+
+        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
+        {
+            if (memcmp(buffer_ptr + 4, chunk_type, 4) != 0) output_buffer_size += (4 + 4 + chunk_size + 4);
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        }
+
+        if ((output_buffer == NULL) || (output_buffer_capacity < output_buffer_size)) return output_buffer_size;
+
+        // Copy chunks data into output buffer
+        size_t output_offset = 0;
+        memcpy(output_buffer, png_signature, 8);        // Copy PNG signature
+        output_offset += 8;
+        buffer_ptr = buffer + 8;
+        chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
+        {
+            // If chunk type is not the requested, just copy input data into output buffer
+            if (memcmp(buffer_ptr + 4, chunk_type, 4) != 0)
+            {
+                memcpy(output_buffer + output_offset, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
+                output_offset += (4 + 4 + chunk_size + 4);
+            }
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        }
+
+        // Write IEND chunk
+        memcpy(output_buffer + output_offset, buffer_ptr, 4 + 4 + 4);
+    }
+
+    return output_buffer_size;
+}
+
+// Remove all chunks from memory buffer except: IHDR-PLTE-IDAT-IEND (and tRNS if PLTE), into a provided output buffer
+// NOTE: Returns required output size, chunks are walked once and copied while output_buffer fits them,
+// output data is only complete if output_buffer fits the returned size (output never bigger than input)
+size_t rpng_chunk_remove_ancillary_to_buffer(const char *buffer, char *output_buffer, size_t output_buffer_capacity)
+{
+    const char *buffer_ptr = buffer;
+    size_t output_buffer_size = 0;
+
+    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0))  // Check valid PNG file
+    {
+        bool preserve_palette_transparency = false;
+        size_t output_offset = 8;
+        if ((output_buffer != NULL) && (output_buffer_capacity >= 8)) memcpy(output_buffer, png_signature, 8);  // Copy PNG signature
+
+        buffer_ptr += 8;                // Move pointer after signature
+        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
+        {
+            if (memcmp(buffer_ptr + 4, "PLTE", 4) == 0) preserve_palette_transparency = true;
+
+            // If chunk type is mandatory, just copy input data into output buffer
+            if ((memcmp(buffer_ptr + 4, "IHDR", 4) == 0) ||
+                (memcmp(buffer_ptr + 4, "PLTE", 4) == 0) ||
+                (memcmp(buffer_ptr + 4, "IDAT", 4) == 0) ||
+                (preserve_palette_transparency && (memcmp(buffer_ptr + 4, "tRNS", 4) == 0)))
+            {
+                size_t chunk_total_size = 4 + 4 + (size_t)chunk_size + 4;  // Length + FOURCC + chunk_size + CRC32
+                if ((output_buffer != NULL) && (output_buffer_capacity >= output_offset + chunk_total_size)) memcpy(output_buffer + output_offset, buffer_ptr, chunk_total_size);
+                output_offset += chunk_total_size;
+            }
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        }
+
+        // Write IEND chunk
+        if ((output_buffer != NULL) && (output_buffer_capacity >= output_offset + 12)) memcpy(output_buffer + output_offset, buffer_ptr, 4 + 4 + 4);
+        output_buffer_size = output_offset + 12;
+    }
+
+    return output_buffer_size;
+}
+
+// Write one new chunk after IHDR (any kind) from memory buffer into a provided output buffer
+// NOTE: Returns required output size, data is only written if output_buffer fits it
+size_t rpng_chunk_write_to_buffer(const char *buffer, rpng_chunk chunk, char *output_buffer, size_t output_buffer_capacity)
+{
+    const char *buffer_ptr = buffer;
+    size_t output_buffer_size = 0;
+
+    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0))  // Check valid PNG file
+    {
+        // Compute required output size from chunks headers
+        output_buffer_size = 8 + 12;    // PNG signature + IEND chunk
+        buffer_ptr += 8;                // Move pointer after signature
+
+        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
+        {
+            output_buffer_size += (4 + 4 + chunk_size + 4);
+            if (memcmp(buffer_ptr + 4, "IHDR", 4) == 0) output_buffer_size += (4 + 4 + chunk.length + 4);
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        }
+
+        if ((output_buffer == NULL) || (output_buffer_capacity < output_buffer_size)) return output_buffer_size;
+
+        // Copy chunks data into output buffer
+        size_t output_offset = 0;
+        memcpy(output_buffer, png_signature, 8);        // Copy PNG signature
+        output_offset += 8;
+        buffer_ptr = buffer + 8;
+        chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0) // While IEND chunk not reached
+        {
+            memcpy(output_buffer + output_offset, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
+            output_offset += (4 + 4 + chunk_size + 4);
+
+            // Check if we just copied the IHDR chunk to append our chunk after it
+            if (memcmp(buffer_ptr + 4, "IHDR", 4) == 0)
+            {
+                int chunk_length_be = swap_endian(chunk.length);
+                memcpy(output_buffer + output_offset, &chunk_length_be, sizeof(int));    // Write chunk length
+                memcpy(output_buffer + output_offset + 4, chunk.type, 4);               // Write chunk type
+                memcpy(output_buffer + output_offset + 4 + 4, chunk.data, chunk.length); // Write chunk data
+
+                // Compute CRC32 over type + data, directly from output buffer
+                unsigned int crc = compute_crc32((unsigned char *)output_buffer + output_offset + 4, 4 + chunk.length);
+                crc = swap_endian(crc);
+                memcpy(output_buffer + output_offset + 4 + 4 + chunk.length, &crc, 4);   // Write CRC32
+
+                output_offset += (4 + 4 + chunk.length + 4);  // Update output file file_size with new chunk
+            }
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);           // Move pointer to next chunk of input data
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);  // Compute next chunk file_size
+        }
+
+        // Write IEND chunk
+        memcpy(output_buffer + output_offset, buffer_ptr, 4 + 4 + 4);
+    }
+
+    return output_buffer_size;
+}
+
+// Combine multiple IDAT chunks into a single one, into a provided output buffer
+// NOTE: Returns required output size, data is only written if output_buffer fits it
+size_t rpng_chunk_combine_image_data_to_buffer(const char *buffer, char *output_buffer, size_t output_buffer_capacity)
+{
+    const char *buffer_ptr = buffer;
+    size_t output_buffer_size = 0;
+
+    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0)) // Check valid PNG file
+    {
+        // Compute required output size from chunks headers
+        size_t idata_size = 0;
+        output_buffer_size = 8 + 12 + 12;   // PNG signature + IEND chunk + IDAT chunk (without data)
+        buffer_ptr += 8;                    // Move pointer after signature
+
+        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0)         // While IEND chunk not reached
+        {
+            if (memcmp(buffer_ptr + 4, "IDAT", 4) == 0) idata_size += chunk_size;
+            else output_buffer_size += (4 + 4 + chunk_size + 4);
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        }
+
+        // WARNING: Chunk length is limited to 2^31 - 1 bytes by PNG specification
+        if (idata_size > 0x7fffffff)
+        {
+            RPNG_LOG("WARNING: IDAT chunks data too big to be combined in a single chunk\n");
+            return 0;
+        }
+
+        output_buffer_size += idata_size;
+
+        if ((output_buffer == NULL) || (output_buffer_capacity < output_buffer_size)) return output_buffer_size;
+
+        // Copy chunks data into output buffer
+        // NOTE: Combined IDAT chunk is placed after the last non-IDAT chunk previous to IEND,
+        // IDAT data is gathered directly at its final position in the output buffer
+        size_t output_offset = 8;
+        size_t idata_offset = output_buffer_size - 12 - idata_size - 12;
+        size_t idata_written = 0;
+        unsigned int crc = update_crc32(0, (const unsigned char *)"IDAT", 4);
+
+        memcpy(output_buffer, png_signature, 8); // Copy PNG signature
+        buffer_ptr = buffer + 8;
+        chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0)         // While IEND chunk not reached
+        {
+            // If IDAT chunk just copy data into combined IDAT chunk data
+            if (memcmp(buffer_ptr + 4, "IDAT", 4) == 0)
+            {
+                memcpy(output_buffer + idata_offset + 8 + idata_written, buffer_ptr + 8, chunk_size);
+                crc = update_crc32(crc, (const unsigned char *)buffer_ptr + 8, chunk_size);
+                idata_written += chunk_size;
+            }
+            else
+            {
+                memcpy(output_buffer + output_offset, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
+                output_offset += (4 + 4 + chunk_size + 4);
+            }
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        }
+
+        // Write IDAT combined chunk header and CRC
+        unsigned int idata_size_be = swap_endian((unsigned int)idata_size);
+        memcpy(output_buffer + idata_offset, &idata_size_be, 4);
+        memcpy(output_buffer + idata_offset + 4, "IDAT", 4);
+        crc = swap_endian(crc);
+        memcpy(output_buffer + idata_offset + 4 + 4 + idata_size, &crc, 4);
+
+        // Write IEND chunk
+        memcpy(output_buffer + output_buffer_size - 12, buffer_ptr, 4 + 4 + 4);
+    }
+
+    return output_buffer_size;
+}
+
+// Split IDAT chunks into multiple ones, into a provided output buffer
+// NOTE: Returns required output size, data is only written if output_buffer fits it
+size_t rpng_chunk_split_image_data_to_buffer(const char *buffer, int split_size, char *output_buffer, size_t output_buffer_capacity)
+{
+    const char *buffer_ptr = buffer;
+    size_t output_buffer_size = 0;
+
+    if ((buffer_ptr != NULL) && (split_size > 0) && (memcmp(buffer_ptr, png_signature, 8) == 0))  // Check valid PNG file
+    {
+        // Compute required output size from chunks headers
+        output_buffer_size = 8 + 12;    // PNG signature + IEND chunk
+        buffer_ptr += 8;                // Move pointer after signature
+
+        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0)         // While IEND chunk not reached
+        {
+            output_buffer_size += (4 + 4 + chunk_size + 4);
+
+            // Every IDAT chunk split adds one chunk header + CRC32
+            if ((memcmp(buffer_ptr + 4, "IDAT", 4) == 0) && (chunk_size > (unsigned int)split_size))
+            {
+                output_buffer_size += ((chunk_size - 1)/split_size)*12;
+            }
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        }
+
+        if ((output_buffer == NULL) || (output_buffer_capacity < output_buffer_size)) return output_buffer_size;
+
+        // Copy chunks data into output buffer
+        size_t output_offset = 0;
+        memcpy(output_buffer, png_signature, 8);    // Copy PNG signature
+        output_offset += 8;
+        buffer_ptr = buffer + 8;
+        chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+
+        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0)         // While IEND chunk not reached
+        {
+            // If IDAT chunk, split into multiple sized chunks
+            if ((memcmp(buffer_ptr + 4, "IDAT", 4) == 0) && (chunk_size > (unsigned int)split_size))
+            {
+                // Split chunk into pieces, written directly into output buffer
+                unsigned int chunk_remain_size = chunk_size;
+                const char *buffer_ptr_offset = buffer_ptr + 4 + 4;
+
+                while (chunk_remain_size > 0)
+                {
+                    unsigned int piece_size = (chunk_remain_size > (unsigned int)split_size)? (unsigned int)split_size : chunk_remain_size;
+                    unsigned int piece_size_be = swap_endian(piece_size);
+                    memcpy(output_buffer + output_offset, &piece_size_be, 4);
+                    memcpy(output_buffer + output_offset + 4, "IDAT", 4);
+                    memcpy(output_buffer + output_offset + 4 + 4, buffer_ptr_offset, piece_size);
+                    unsigned int crc = compute_crc32((unsigned char *)(output_buffer + output_offset + 4), 4 + piece_size);
+                    crc = swap_endian(crc);
+                    memcpy(output_buffer + output_offset + 4 + 4 + piece_size, &crc, 4);
+
+                    chunk_remain_size -= piece_size;
+                    buffer_ptr_offset += piece_size;
+                    output_offset += (piece_size + 12);
+                }
+            }
+            else
+            {
+                memcpy(output_buffer + output_offset, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
+                output_offset += (4 + 4 + chunk_size + 4);
+            }
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        }
+
+        // Write IEND chunk
+        memcpy(output_buffer + output_offset, buffer_ptr, 4 + 4 + 4);
+    }
+
+    return output_buffer_size;
+}
+
+// Check chunks CRC is valid from memory buffer
+bool rpng_chunk_check_all_valid_from_memory(const char *buffer)
+{
+    return (rpng_chunk_find_invalid_from_memory(buffer, NULL) == -1);
+}
+
+// Find first chunk with invalid CRC from memory buffer
+//  - Returns index of the first invalid chunk, -1 if all chunks are valid or -2 on error (not a PNG, memory allocation failed)
+//  - Offset of the invalid chunk from buffer start is returned by reference (if provided), 0 if no invalid chunk
+// NOTE: CRC is computed in place over chunk type and data (no data copy required),
+// if OpenMP is enabled, chunks are validated in parallel for big enough buffers
+int rpng_chunk_find_invalid_from_memory(const char *buffer, size_t *offset)
+{
+    int result = -2;
+    size_t chunk_offset = 0;
+
+    if ((buffer != NULL) && (memcmp(buffer, png_signature, 8) == 0))  // Check valid PNG file
+    {
+        int count = rpng_chunk_count_from_memory(buffer);
+        size_t *chunk_offsets = (size_t *)RPNG_MALLOC(count*sizeof(size_t));
+
+        if (chunk_offsets != NULL)
+        {
+            // Register all chunks offsets, only chunks headers are accessed
+            size_t data_size = 8;
+            for (int i = 0; i < count; i++)
+            {
+                chunk_offsets[i] = data_size;
+                data_size += (4 + 4 + (size_t)swap_endian(((unsigned int *)(buffer + data_size))[0]) + 4);
+            }
+
+            int invalid_index = count;
+
+#if defined(_OPENMP)
+            #pragma omp parallel for schedule(dynamic) if (data_size >= RPNG_PARALLEL_MIN_SIZE)
+#endif
+            for (int i = 0; i < count; i++)
+            {
+                const unsigned char *chunk_ptr = (const unsigned char *)buffer + chunk_offsets[i];
+                unsigned int chunk_size = swap_endian(((unsigned int *)chunk_ptr)[0]);
+                unsigned int crc = update_crc32(0, chunk_ptr + 4, 4 + chunk_size);
+
+                // Check computed CRC matches provided CRC
+                if (swap_endian(((unsigned int *)(chunk_ptr + 8 + chunk_size))[0]) != crc)
+                {
+#if defined(_OPENMP)
+                    #pragma omp critical
+#endif
+                    {
+                        if (i < invalid_index) invalid_index = i;
+                    }
+                }
+            }
+
+            if (invalid_index < count)
+            {
+                result = invalid_index;
+                chunk_offset = chunk_offsets[invalid_index];
+            }
+            else result = -1;
+
+            RPNG_FREE(chunk_offsets);
+        }
+        else RPNG_LOG("WARNING: Chunks offsets memory could not be allocated\n");
+    }
+
+    if (offset != NULL) *offset = (result < 0)? 0 : chunk_offset;
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------
+// Module specific Functions Definition
+//----------------------------------------------------------------------------------
+
+// Filter one scanline, output is the filter type byte followed by filtered data
+//  - Previous scanline is NULL for first scanline
+//  - Filter type -1 selects the best filter for the scanline by heuristic
+static void rpng_filter_row(unsigned char *output, const unsigned char *row, const unsigned char *previous, int size, int pixel_size, int filter)
+{
+    // NOTE: First pixel bytes have no left pixel (a = c = 0) and first scanline has no above one (b = c = 0),
+    // they are processed out of the main loops, so every loop runs without per-byte conditions
+    int first = (pixel_size < size)? pixel_size : size;
+
+    if (filter == -1)
+    {
+        // Choose the best filter type for the scanline
+        // REF: https://www.w3.org/TR/PNG-Encoders.html#E.Filter-selection
+        int sum_value[5] = { 0 };
+
+        // Heuristic: Compute the output scanline using all five filters
+        // REF: https://www.w3.org/TR/PNG/#9Filters
+        // x = current byte, a = left pixel byte (from current), b = above pixel byte (from current), c = left pixel byte (from b)
+        if (previous == NULL)
+        {
+            // NOTE: Without above scanline: Up is None, Paeth is Sub
+            for (int p = 0; p < first; p++)
+            {
+                int x = abs((signed char)row[p]);
+                sum_value[0] += x; sum_value[1] += x; sum_value[2] += x; sum_value[3] += x; sum_value[4] += x;
+            }
+
+            for (int p = first; p < size; p++)
+            {
+                int x = (int)row[p], a = (int)row[p - pixel_size];
+                sum_value[0] += abs((signed char)x);
+                sum_value[1] += abs((signed char)(x - a));
+                sum_value[3] += abs((signed char)(x - (a>>1)));
+            }
+
+            sum_value[2] = sum_value[0];
+            sum_value[4] = sum_value[1];
+        }
+        else
+        {
+            // NOTE: Without left pixel: Sub is None, Paeth is Up
+            for (int p = 0; p < first; p++)
+            {
+                int x = (int)row[p], b = (int)previous[p];
+                sum_value[0] += abs((signed char)x);
+                sum_value[1] += abs((signed char)x);
+                sum_value[2] += abs((signed char)(x - b));
+                sum_value[3] += abs((signed char)(x - (b>>1)));
+                sum_value[4] += abs((signed char)(x - b));
+            }
+
+            for (int p = first; p < size; p++)
+            {
+                int x = (int)row[p], a = (int)row[p - pixel_size];
+                int b = (int)previous[p], c = (int)previous[p - pixel_size];
+                sum_value[0] += abs((signed char)x);
+                sum_value[1] += abs((signed char)(x - a));
+                sum_value[2] += abs((signed char)(x - b));
+                sum_value[3] += abs((signed char)(x - ((a + b)>>1)));
+                sum_value[4] += abs((signed char)(x - rpng_paeth_predictor(a, b, c)));
+            }
+        }
+
+        // Select the filter that gives the smallest sum of absolute values of outputs.
+        // NOTE: Considering the output bytes as signed differences for the test.
+        filter = 0;
+        int best_value = sum_value[0];
+
+        for (int f = 1; f < 5; f++)
+        {
+            if (sum_value[f] < best_value)
+            {
+                best_value = sum_value[f];
+                filter = f;
+            }
+        }
+    }
+    else if ((filter < 0) || (filter > 4)) filter = 0;
+
+    // NOTE: Filters requiring above scanline are applied as None/Sub filters on first scanline
+    int applied = filter;
+    if (previous == NULL) applied = (filter == 2)? 0 : (filter == 4)? 1 : filter;
+
+    // Register scanline filter byte
+    output[0] = (unsigned char)filter;
+    output++;
+
+    // Apply the filter to scanline, byte by byte
+    switch (applied)
+    {
+        case 0: memcpy(output, row, size); break;
+        case 1:
+        {
+            memcpy(output, row, first);
+            for (int p = first; p < size; p++) output[p] = (unsigned char)(row[p] - row[p - pixel_size]);
+        } break;
+        case 2: for (int p = 0; p < size; p++) output[p] = (unsigned char)(row[p] - previous[p]); break;
+        case 3:
+        {
+            if (previous == NULL)
+            {
+                memcpy(output, row, first);
+                for (int p = first; p < size; p++) output[p] = (unsigned char)(row[p] - (row[p - pixel_size]>>1));
+            }
+            else
+            {
+                for (int p = 0; p < first; p++) output[p] = (unsigned char)(row[p] - (previous[p]>>1));
+                for (int p = first; p < size; p++) output[p] = (unsigned char)(row[p] - ((row[p - pixel_size] + previous[p])>>1));
+            }
+        } break;
+        case 4:
+        {
+            for (int p = 0; p < first; p++) output[p] = (unsigned char)(row[p] - previous[p]);
+            for (int p = first; p < size; p++) output[p] = (unsigned char)(row[p] - rpng_paeth_predictor(row[p - pixel_size], previous[p], previous[p - pixel_size]));
+        } break;
+        default: break;
+    }
+}
+
+// Create compressor state for memory profile, sized to data to be compressed
+//  - Window, hash table and blocks are reduced for small data, matches can not be further than data size
+//  - Provided compressor state is reused if sizes are the same, destroyed otherwise
+//  - Returns NULL if compressor state could not be allocated
+static struct sdefl *rpng_deflate_create(struct sdefl *sde, int memory_profile, size_t data_size)
+{
+    int hash_bits = 15;
+    int window_bits = 15;
+    int block_size = 256*1024;
+
+    if (memory_profile <= 0) memory_profile = RPNG_MEMORY_PROFILE;
+    if (memory_profile == RPNG_MEMORY_SMALL) { hash_bits = 12; window_bits = 12; block_size = 16*1024; }
+    else if (memory_profile == RPNG_MEMORY_LARGE) hash_bits = 17;
+
+    int data_bits = 8;
+    while ((data_bits < 30) && (((size_t)1 << data_bits) < data_size)) data_bits++;
+    if (window_bits > data_bits) window_bits = data_bits;
+    if (hash_bits > data_bits) hash_bits = data_bits;
+    if ((size_t)block_size > data_size) block_size = (int)data_size;
+
+    // Clamp to sdefl limits (same as sdefl_create()), so sizes can be compared before allocating
+    if (hash_bits < SDEFL_HASH_BITS_MIN) hash_bits = SDEFL_HASH_BITS_MIN;
+    if (hash_bits > SDEFL_HASH_BITS_MAX) hash_bits = SDEFL_HASH_BITS_MAX;
+    if (window_bits < SDEFL_WIN_BITS_MIN) window_bits = SDEFL_WIN_BITS_MIN;
+    if (window_bits > SDEFL_WIN_BITS) window_bits = SDEFL_WIN_BITS;
+    if (block_size < SDEFL_BLK_MAX_MIN) block_size = SDEFL_BLK_MAX_MIN;
+    if (block_size > SDEFL_BLK_MAX) block_size = SDEFL_BLK_MAX;
+
+    struct sdefl *result = sde;
+
+    // NOTE: Provided state is reused without any allocation if sizes are the same,
+    // otherwise it's destroyed before allocating the new one
+    if ((sde == NULL) || (sde->hash_bits != hash_bits) || (sde->win_bits != window_bits) || (sde->blk_max != block_size))
+    {
+        sdefl_destroy(sde);
+        result = sdefl_create(hash_bits, window_bits, block_size);
+    }
+
+    return result;
+}
+
+// Get maximum zlib stream size for data size, from codec if provided
+static int rpng_compress_bound(int size)
+{
+    if (rpng_codec_custom.compress_bound != NULL) return rpng_codec_custom.compress_bound(rpng_codec_custom.user_data, size);
+
+    return sdefl_bound(size);
+}
+
+// Close compression context, compressor state and filtering buffer memory is freed
+static void rpng_deflate_context_close(rpng_deflate_context *context)
+{
+    sdefl_destroy(context->sde);
+    RPNG_FREE(context->data_filtered);
+    context->sde = NULL;
+    context->data_filtered = NULL;
+    context->data_filtered_capacity = 0;
+}
+
+// Prefilter and compress image data into provided output buffer
+//  - Output buffer must fit rpng_compress_bound() of filtered data size: image data size plus 1 byte per scanline
+//  - Pack depth (1/2/4) packs 8 bit values (pixel size 1) into sub-byte values, packed scanlines are not filtered
+//  - Interlaced image data (Adam7 option) is filtered pass by pass, every pass scanline gathered from image data
+//  - Returns compressed data size, 0 if data could not be compressed
+static int rpng_deflate_image_data(rpng_deflate_context *context, const char *image_data, int width, int height, int pixel_size, int pack_depth, int forced_filter_type, const rpng_save_options *options, unsigned char *output)
+{
+    int output_size = 0;
+    bool interlace = (options != NULL) && options->interlace;
+    int level = ((options != NULL) && (options->compression_level > 0))? options->compression_level : RPNG_COMPRESSION_LEVEL;
+    int strategy = (options != NULL)? options->strategy : RPNG_STRATEGY_DEFAULT;
+    int memory_profile = (options != NULL)? options->memory_profile : 0;
+
+    // Image data pre-processing to append filter type byte to every scanline
+    // WARNING: Compressor sizes are int, data size is checked to avoid overflows
+    size_t filtered_data_size = rpng_get_filtered_data_size(width, height, (pack_depth > 0)? pack_depth : pixel_size*8, interlace);
+
+    if ((filtered_data_size == 0) || (filtered_data_size > RPNG_MAX_DEFLATE_SIZE))
+    {
+        RPNG_LOG("WARNING: Image data size not valid or too big to be compressed\n");
+        return output_size;
+    }
+
+    int scanline_size = width*pixel_size;
+    int data_filtered_size = (int)filtered_data_size;
+
+    // Compression context memory is reused if provided, only reallocated if bigger filtering buffer is required
+    rpng_deflate_context temp_context = { 0 };
+    if (context == NULL) context = &temp_context;
+
+    // NOTE: Compressor state is only required by internal codec
+    bool custom_codec = (rpng_codec_custom.compress != NULL);
+    if (!custom_codec) context->sde = rpng_deflate_create(context->sde, memory_profile, filtered_data_size);
+    if (context->data_filtered_capacity < (size_t)data_filtered_size)
+    {
+        RPNG_FREE(context->data_filtered);
+        context->data_filtered = (unsigned char *)RPNG_MALLOC(data_filtered_size);
+        context->data_filtered_capacity = (context->data_filtered != NULL)? data_filtered_size : 0;
+    }
+
+    // Interlaced passes scanlines are gathered into two scanlines (current and previous, for filtering)
+    unsigned char *rows_gathered = interlace? (unsigned char *)RPNG_MALLOC((size_t)scanline_size*2) : NULL;
+
+    if ((!custom_codec && (context->sde == NULL)) || (context->data_filtered == NULL) || (interlace && (rows_gathered == NULL)))
+    {
+        RPNG_FREE(rows_gathered);
+        rpng_deflate_context_close(context);
+        return output_size;
+    }
+
+    unsigned char *row_filtered = context->data_filtered;
+
+    for (int pass = 0; pass < (interlace? 7 : 1); pass++)
+    {
+        int pass_width = width;
+        int pass_height = height;
+        if (interlace) rpng_get_pass_size(width, height, pass, &pass_width, &pass_height);
+
+        // NOTE: Passes with no pixels are empty, they contain no scanlines
+        if ((pass_width == 0) || (pass_height == 0)) continue;
+
+        int pass_scanline_size = pass_width*pixel_size;
+
+        for (int y = 0; y < pass_height; y++)
+        {
+            const unsigned char *row = (const unsigned char *)image_data + (size_t)scanline_size*y;
+            const unsigned char *previous = (y > 0)? row - scanline_size : NULL;
+
+            if (interlace)
+            {
+                row = rows_gathered + (size_t)(y%2)*scanline_size;
+                previous = (y > 0)? rows_gathered + (size_t)((y + 1)%2)*scanline_size : NULL;
+                rpng_gather_row((unsigned char *)row, (const unsigned char *)image_data, width, pixel_size, pass, y, pass_width);
+            }
+
+            if (pack_depth > 0)
+            {
+                // NOTE: Filter type 0 (None) is usually the best one for bit depths lower than 8
+                row_filtered[0] = 0;
+                rpng_pack_row(row_filtered + 1, row, pass_width, pack_depth);
+                row_filtered += (pass_width*pack_depth + 7)/8 + 1;
+            }
+            else
+            {
+                rpng_filter_row(row_filtered, row, previous, pass_scanline_size, pixel_size, forced_filter_type);
+                row_filtered += pass_scanline_size + 1;
+            }
+        }
+    }
+
+    RPNG_FREE(rows_gathered);
+
+    // Compress filtered image data and generate a valid zlib stream
+    if (custom_codec)
+    {
+        // NOTE: Output buffer fits codec bound of filtered data size (interlaced size, bigger or equal)
+        int output_capacity = rpng_compress_bound(data_filtered_size);
+        output_size = rpng_codec_custom.compress(rpng_codec_custom.user_data, (char *)output, output_capacity, (const char *)context->data_filtered, data_filtered_size, level);
+        if (output_size < 0) output_size = 0;
+    }
+    else
+    {
+        // NOTE: RLE strategy looks for matches at distance of one pixel (filtered bytes repeated by pixel)
+        context->sde->strat = (strategy == RPNG_STRATEGY_RLE)? SDEFL_STRAT_RLE : (strategy == RPNG_STRATEGY_HUFFMAN_ONLY)? SDEFL_STRAT_HUFF : SDEFL_STRAT_DEF;
+        context->sde->strat_dist = (pack_depth > 0)? 1 : pixel_size;
+        output_size = zsdeflate(context->sde, output, context->data_filtered, data_filtered_size, level);
+    }
+
+    if ((options != NULL) && (options->stats != NULL))
+    {
+        // NOTE: Blocks decisions are only available from internal compressor
+        memset(options->stats, 0, sizeof(rpng_save_stats));
+        options->stats->data_size = data_filtered_size;
+        options->stats->compressed_size = output_size;
+
+        if (!custom_codec)
+        {
+            options->stats->blocks_stored = context->sde->stats.blk_raw;
+            options->stats->blocks_fixed = context->sde->stats.blk_fixed;
+            options->stats->blocks_dynamic = context->sde->stats.blk_dyn;
+            options->stats->blocks_search_skipped = context->sde->stats.blk_lit;
+        }
+    }
+
+    if (context == &temp_context) rpng_deflate_context_close(&temp_context);
+
+    if (output_size > 0) RPNG_LOG("INFO: Image data deflated successfully: %i bytes -> %i bytes\n", data_filtered_size, output_size);
+    else RPNG_LOG("INFO: Image data deflating failed\n");
+
+    return output_size;
+}
+
+// Gather one Adam7 pass scanline pixels from its image scanline (inverse of rpng_scatter_row())
+// NOTE: Copy kernels are specialized by pixel size (constant size copies), last pass scanlines are contiguous
+static void rpng_gather_row(unsigned char *row, const unsigned char *image_data, int width, int pixel_size, int pass, int pass_row, int pass_width)
+{
+    size_t y = (size_t)adam7_y_start[pass] + (size_t)pass_row*adam7_y_step[pass];
+    size_t step = (size_t)adam7_x_step[pass]*pixel_size;
+    const unsigned char *input = image_data + y*width*pixel_size + (size_t)adam7_x_start[pass]*pixel_size;
+
+    if (adam7_x_step[pass] == 1) memcpy(row, input, (size_t)pass_width*pixel_size);
+    else
+    {
+        switch (pixel_size)
+        {
+            case 1: for (int i = 0; i < pass_width; i++) row[i] = input[i*step]; break;
+            case 2: for (int i = 0; i < pass_width; i++) memcpy(row + i*2, input + i*step, 2); break;
+            case 3: for (int i = 0; i < pass_width; i++) memcpy(row + i*3, input + i*step, 3); break;
+            case 4: for (int i = 0; i < pass_width; i++) memcpy(row + i*4, input + i*step, 4); break;
+            case 6: for (int i = 0; i < pass_width; i++) memcpy(row + i*6, input + i*step, 6); break;
+            case 8: for (int i = 0; i < pass_width; i++) memcpy(row + i*8, input + i*step, 8); break;
+            default: break;
+        }
+    }
+}
+
+// Write PNG chunk into output: length, type, data and CRC
+//  - Returns chunk size written
+static int rpng_store_chunk(unsigned char *output, const char *type, const unsigned char *data, int length)
+{
+    unsigned int length_be = swap_endian(length);
+    memcpy(output, &length_be, 4);
+    memcpy(output + 4, type, 4);
+    if (length > 0) memcpy(output + 8, data, length);
+    unsigned int crc = swap_endian(compute_crc32(output + 4, 4 + length));
+    memcpy(output + 8 + length, &crc, 4);
+
+    return length + 12;
+}
+
+// Write PNG data header: signature, IHDR, PLTE and tRNS (if palette provided), IDAT chunk length and type
+//  - IDAT chunk length is written by rpng_write_image_trailer(), once image data has been compressed
+//  - Output must fit RPNG_MAX_HEADER_SIZE, returns header size written
+static int rpng_write_image_header(unsigned char *output, int width, int height, int color_type, int bit_depth, int interlace, const rpng_palette *palette)
+{
+    int size = 0;
+
+    rpng_chunk_IHDR image_info = { 0 };
+    image_info.width = swap_endian(width);
+    image_info.height = swap_endian(height);
+    image_info.bit_depth = (unsigned char)bit_depth;
+    image_info.color_type = (unsigned char)color_type;
+    image_info.interlace = (unsigned char)interlace;
+
+    // Write PNG signature
+    memcpy(output, png_signature, 8);
+    size += 8;
+
+    // Write PNG chunk IHDR
+    size += rpng_store_chunk(output + size, "IHDR", (const unsigned char *)&image_info, 13);
+
+    if (palette != NULL)
+    {
+        // Write PNG chunk PLTE (palette), colors saved as RGB888
+        unsigned char palette_data[256*3] = { 0 };
+        bool trns_required = false;
+
+        for (int i = 0; i < palette->color_count; i++)
+        {
+            palette_data[i*3 + 0] = palette->colors[i].r;
+            palette_data[i*3 + 1] = palette->colors[i].g;
+            palette_data[i*3 + 2] = palette->colors[i].b;
+
+            // Verify if tRNS chunk with palette alpha values is required (if there is any alpha != 255)
+            if (palette->colors[i].a != 255) trns_required = true;
+        }
+
+        size += rpng_store_chunk(output + size, "PLTE", palette_data, palette->color_count*3);
+
+        // Write PNG chunk tRNS (palette alpha values, if required)
+        if (trns_required)
+        {
+            for (int i = 0; i < palette->color_count; i++) palette_data[i] = palette->colors[i].a;
+
+            size += rpng_store_chunk(output + size, "tRNS", palette_data, palette->color_count);
+        }
+    }
+
+    // Write PNG chunk IDAT length (updated once data is compressed) and type
+    memset(output + size, 0, 4);
+    memcpy(output + size + 4, "IDAT", 4);
+    size += 8;
+
+    return size;
+}
+
+// Write PNG data trailer: IDAT chunk CRC and IEND chunk, IDAT chunk length is updated into header
+//  - IDAT CRC is computed incrementally over chunk type and compressed data, data is not copied
+//  - Returns trailer size written (16 bytes)
+static int rpng_write_image_trailer(unsigned char *output, unsigned char *header, int header_size, const unsigned char *idat_data, int idat_size)
+{
+    unsigned int length_IDAT = swap_endian(idat_size);
+    memcpy(header + header_size - 8, &length_IDAT, 4);
+
+    unsigned int crc = update_crc32(update_crc32(0, header + header_size - 4, 4), idat_data, idat_size);
+    crc = swap_endian(crc);
+    memcpy(output, &crc, 4);
+
+    // Write PNG chunk IEND
+    unsigned char chunk_IEND[12] = { 0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82 };
+    memcpy(output + 4, chunk_IEND, 12);
+
+    return 16;
+}
+
+// Reduce image data to smallest lossless color type, analyzing all pixels in a single pass:
+//  - Alpha channel removed if all pixels are opaque
+//  - Color converted to gray if all pixels have R == G == B
+//  - 16 bit data converted to 8 bit if all values are 8 bit values scaled (high byte == low byte)
+//  - 8 bit data converted to indexed data (palette provided) if image has 256 or less colors and indexed data is smaller
+//  - Color channels, bit depth and palette (colors array must fit 256 colors) are updated by reference
+//  - Returns reduced image data or NULL if image data can not be reduced
+static char *rpng_reduce_image_data(const char *data, int width, int height, int *color_channels, int *bit_depth, rpng_palette *palette)
+{
+    char *reduced_data = NULL;
+
+    int channels = *color_channels;
+    int byte_size = *bit_depth/8;
+    int pixel_size = channels*byte_size;
+    size_t row_size = (size_t)width*pixel_size;
+    bool has_alpha = ((channels == 2) || (channels == 4));
+    bool has_color = (channels >= 3);
+
+    // Colors hash table, used to count image colors, stops counting over 256 colors
+    // NOTE: Colors are counted using 8 bit values (high byte), only valid if data can be reduced to 8 bit
+    unsigned int color_keys[1024] = { 0 };
+    short color_indexes[1024] = { 0 };
+    int color_count = 0;
+    memset(color_indexes, 0xff, sizeof(color_indexes));
+
+    // Pixels analysis, accumulated per scanline:
+    //  - alpha_and: alpha values AND, 0xff if all pixels opaque
+    //  - gray_or: color channels differences OR, 0 if all pixels gray
+    //  - depth_or: 16 bit values high-low bytes differences OR, 0 if all values are 8 bit
+    // NOTE: Scanline accumulation loops are branch-free, so they can be vectorized by the compiler
+    unsigned char alpha_and = 0xff;
+    unsigned char gray_or = 0;
+    unsigned char depth_or = 0;
+
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char *row = (const unsigned char *)data + row_size*y;
+
+        if (byte_size == 2) for (size_t i = 0; i < row_size; i += 2) depth_or |= row[i] ^ row[i + 1];
+
+        if (has_alpha) for (size_t i = pixel_size - byte_size; i < row_size; i += pixel_size) alpha_and &= row[i] & row[i + byte_size - 1];
+
+        if (has_color)
+        {
+            for (size_t i = 0; i < row_size; i += pixel_size)
+            {
+                gray_or |= (row[i] ^ row[i + byte_size]) | (row[i] ^ row[i + 2*byte_size]) |
+                           (row[i + byte_size - 1] ^ row[i + 2*byte_size - 1]) | (row[i + byte_size - 1] ^ row[i + 3*byte_size - 1]);
+            }
+        }
+
+        // Count image colors, consecutive pixels with same color are not looked up again
+        unsigned int previous_key = 0;
+        for (size_t i = 0; (i < row_size) && (color_count <= 256); i += pixel_size)
+        {
+            unsigned int r = row[i];
+            unsigned int g = has_color? row[i + byte_size] : r;
+            unsigned int b = has_color? row[i + 2*byte_size] : r;
+            unsigned int a = has_alpha? row[i + pixel_size - byte_size] : 255;
+            unsigned int key = r | (g << 8) | (b << 16) | (a << 24);
+
+            if ((i > 0) && (key == previous_key)) continue;
+            previous_key = key;
+
+            unsigned int slot = (key*2654435761u) >> 22;
+            while ((color_indexes[slot] != -1) && (color_keys[slot] != key)) slot = (slot + 1) & 1023;
+
+            if (color_indexes[slot] == -1)
+            {
+                if (color_count < 256)
+                {
+                    color_keys[slot] = key;
+                    color_indexes[slot] = (short)color_count;
+                    palette->colors[color_count].r = (unsigned char)r;
+                    palette->colors[color_count].g = (unsigned char)g;
+                    palette->colors[color_count].b = (unsigned char)b;
+                    palette->colors[color_count].a = (unsigned char)a;
+                }
+
+                color_count++;
+            }
+        }
+    }
+
+    // Smallest lossless representation selection
+    int reduced_byte_size = ((byte_size == 2) && (depth_or == 0))? 1 : byte_size;
+    bool keep_color = (has_color && (gray_or != 0));
+    bool keep_alpha = (has_alpha && (alpha_and != 0xff));
+    int reduced_channels = (keep_color? 3 : 1) + (keep_alpha? 1 : 0);
+    size_t reduced_size = (size_t)width*height*reduced_channels*reduced_byte_size;
+
+    // Indexed data requires 1 byte per pixel plus palette (PLTE + tRNS)
+    bool indexed = (reduced_byte_size == 1) && (color_count <= 256) && (((size_t)width*height + color_count*4) < reduced_size);
+
+    if (!indexed && (reduced_channels == channels) && (reduced_byte_size == byte_size)) return reduced_data;
+
+    reduced_data = (char *)RPNG_MALLOC(indexed? (size_t)width*height : reduced_size);
+    if (reduced_data == NULL) return reduced_data;     // NOTE: Image data is saved as provided
+
+    unsigned char *output = (unsigned char *)reduced_data;
+
+    if (indexed)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            const unsigned char *row = (const unsigned char *)data + row_size*y;
+            unsigned int previous_key = 0;
+            unsigned char index = 0;
+
+            for (size_t i = 0; i < row_size; i += pixel_size)
+            {
+                unsigned int r = row[i];
+                unsigned int g = has_color? row[i + byte_size] : r;
+                unsigned int b = has_color? row[i + 2*byte_size] : r;
+                unsigned int a = has_alpha? row[i + pixel_size - byte_size] : 255;
+                unsigned int key = r | (g << 8) | (b << 16) | (a << 24);
+
+                if ((i == 0) || (key != previous_key))
+                {
+                    unsigned int slot = (key*2654435761u) >> 22;
+                    while (color_keys[slot] != key) slot = (slot + 1) & 1023;
+
+                    index = (unsigned char)color_indexes[slot];
+                    previous_key = key;
+                }
+
+                *output++ = index;
+            }
+        }
+
+        palette->color_count = color_count;
+        *color_channels = 1;
+        *bit_depth = 8;
+    }
+    else
+    {
+        // Source channels copied to reduced data, every channel only the high byte if reduced to 8 bit
+        int sources[4] = { 0 };
+        int source_count = 0;
+        if (keep_color) { sources[0] = 0; sources[1] = 1; sources[2] = 2; source_count = 3; }
+        else sources[source_count++] = 0;
+        if (keep_alpha) sources[source_count++] = channels - 1;
+
+        for (int y = 0; y < height; y++)
+        {
+            const unsigned char *row = (const unsigned char *)data + row_size*y;
+
+            for (size_t i = 0; i < row_size; i += pixel_size)
+            {
+                for (int c = 0; c < source_count; c++)
+                {
+                    for (int k = 0; k < reduced_byte_size; k++) *output++ = row[i + sources[c]*byte_size + k];
+                }
+            }
+        }
+
+        *color_channels = reduced_channels;
+        *bit_depth = reduced_byte_size*8;
+    }
+
+    RPNG_LOG("INFO: Image data reduced: %i channels, %i bit -> %i channels, %i bit%s\n", channels, byte_size*8, *color_channels, *bit_depth, indexed? " (indexed)" : "");
+
+    return reduced_data;
+}
+
+// Save image data as PNG data pieces: header, compressed image data and trailer
+//  - If output buffer is provided, pieces are generated in place, buffer capacity must fit rpng_save_bound()
+//  - If filename is provided, compressed data is allocated and pieces are written to file (scatter-gather)
+//  - Palette is only provided for indexed image data (8 bit indexes)
+//  - Saving options can be provided (compression level, interlacing), if NULL default options are used
+//  - Compression context can be provided to reuse its memory between images, if NULL a temporal one is used
+//  - Returns saving result: RPNG_SUCCESS or error code, PNG data size is returned by reference (if provided)
+static int rpng_save_image_data(rpng_deflate_context *context, const char *data, int width, int height, int color_channels, int bit_depth, const rpng_palette *palette, const rpng_save_options *options, const char *filename, char *output_buffer, size_t output_buffer_capacity, size_t *output_size)
+{
+    int result = RPNG_SUCCESS;
+    int color_type = (palette != NULL)? 3 : rpng_get_color_type(color_channels);
+
+    if (output_size != NULL) *output_size = 0;
+
+    if (((bit_depth != 8) && (bit_depth != 16)) || (color_type == -1) ||
+        ((palette != NULL) && ((bit_depth != 8) || (color_channels != 1))))
+    {
+        RPNG_LOG("WARNING: Requested pixel format not supported (%i channels, %i bit per channel)\n", color_channels, bit_depth);
+        return RPNG_ERROR_PIXEL_FORMAT;  // WARNING: Bit depth 1/2/4 not supported
+    }
+
+    if ((palette != NULL) && ((palette->colors == NULL) || (palette->color_count < 1) || (palette->color_count > 256)))
+    {
+        RPNG_LOG("WARNING: Palette not valid, supported colors: [1..256]\n");
+        return RPNG_ERROR_PIXEL_FORMAT;
+    }
+
+    size_t bound = rpng_save_bound(width, height, color_channels, bit_depth);
+
+    if ((data == NULL) || (bound == 0))
+    {
+        RPNG_LOG("WARNING: Image data not valid or too big to be saved\n");
+        return RPNG_ERROR_INVALID_DATA;
+    }
+
+    if ((output_buffer != NULL) && (output_buffer_capacity < bound))
+    {
+        RPNG_LOG("WARNING: Output buffer capacity not enough, required: %zu bytes\n", bound);
+        return RPNG_ERROR_BUFFER_SIZE;
+    }
+
+    if ((output_buffer == NULL) && (filename == NULL)) return RPNG_ERROR_INVALID_DATA;
+
+    int reduce = (options != NULL)? options->reduce_color_type : RPNG_REDUCE_DEFAULT;
+#if defined(RPNG_REDUCE_COLOR_TYPE)
+    if (reduce == RPNG_REDUCE_DEFAULT) reduce = RPNG_REDUCE_ENABLED;
+#endif
+
+    // Image data reduced to smallest lossless color type (if requested and possible), indexed data is saved as provided
+    // NOTE: Reduced data is always smaller than provided data, so saving bound is still valid
+    rpng_color reduced_colors[256] = { 0 };
+    rpng_palette reduced_palette = { 0, reduced_colors };
+    char *reduced_data = ((reduce == RPNG_REDUCE_ENABLED) && (palette == NULL))? rpng_reduce_image_data(data, width, height, &color_channels, &bit_depth, &reduced_palette) : NULL;
+
+    if (reduced_data != NULL)
+    {
+        data = reduced_data;
+        if (reduced_palette.color_count > 0) palette = &reduced_palette;
+        color_type = (palette != NULL)? 3 : rpng_get_color_type(color_channels);
+    }
+
+    // PNG data pieces: generated in place if output buffer provided, otherwise header and trailer are small local
+    // buffers and only compressed data is allocated
+    unsigned char file_header[RPNG_MAX_HEADER_SIZE] = { 0 };
+    unsigned char file_trailer[16] = { 0 };
+    unsigned char *header = (output_buffer != NULL)? (unsigned char *)output_buffer : file_header;
+    // Indexed data is packed into 1/2/4 bit indexes if palette has 16 colors or less
+    int pack_depth = 0;
+    if (palette != NULL) pack_depth = (palette->color_count <= 2)? 1 : (palette->color_count <= 4)? 2 : (palette->color_count <= 16)? 4 : 0;
+
+    int interlace = ((options != NULL) && options->interlace)? 1 : 0;
+    int header_size = rpng_write_image_header(header, width, height, color_type, (pack_depth > 0)? pack_depth : bit_depth, interlace, palette);
+
+    unsigned char *comp_data = header + header_size;
+    if (output_buffer == NULL) comp_data = (unsigned char *)RPNG_MALLOC(bound - RPNG_MAX_HEADER_SIZE - 16);
+
+    // Image data pre-processing to append filter type byte to every scanline
+    // NOTE: Indexed data is not filtered (filter type 0)
+    int pixel_size = color_channels*(bit_depth/8);
+    int comp_data_size = 0;
+    if (comp_data != NULL) comp_data_size = rpng_deflate_image_data(context, data, width, height, pixel_size, pack_depth, (palette != NULL)? 0 : -1, options, comp_data);
+
+    // Security check to verify compression worked
+    if (comp_data_size > 0)
+    {
+        unsigned char *trailer = (output_buffer != NULL)? comp_data + comp_data_size : file_trailer;
+        int trailer_size = rpng_write_image_trailer(trailer, header, header_size, comp_data, comp_data_size);
+
+        if (output_buffer == NULL)
+        {
+            rpng_data_piece pieces[3] = {
+                { header, (size_t)header_size },
+                { comp_data, (size_t)comp_data_size },
+                { trailer, (size_t)trailer_size }
+            };
+
+            result = save_file_from_pieces(filename, pieces, 3);
+        }
+
+        if ((result == RPNG_SUCCESS) && (output_size != NULL)) *output_size = (size_t)header_size + comp_data_size + trailer_size;
+    }
+    else result = RPNG_ERROR_MEMORY_ALLOC;
+
+    if (output_buffer == NULL) RPNG_FREE(comp_data);
+    RPNG_FREE(reduced_data);
+
+    return result;
+}
+
+// Save image data into a new png memory buffer
+//  - Buffer is allocated at rpng_save_bound() size, PNG data is generated in place and buffer is shrunk to PNG data size
+//  - Returns saving result: RPNG_SUCCESS or error code
+static int rpng_save_image_data_to_memory(rpng_deflate_context *context, const char *data, int width, int height, int color_channels, int bit_depth, const rpng_palette *palette, const rpng_save_options *options, char **output, int *output_size)
+{
+    *output = NULL;
+    *output_size = 0;
+
+    size_t bound = rpng_save_bound(width, height, color_channels, bit_depth);
+    char *output_buffer = (char *)RPNG_MALLOC((bound > 0)? bound : 1);
+
+    if (output_buffer == NULL) return RPNG_ERROR_MEMORY_ALLOC;
+
+    size_t output_buffer_size = 0;
+    int result = rpng_save_image_data(context, data, width, height, color_channels, bit_depth, palette, options, NULL, output_buffer, bound, &output_buffer_size);
+
+    if (result == RPNG_SUCCESS)
+    {
+        // NOTE: Shrinking the buffer does not require moving data
+        char *output_buffer_shrunk = (char *)RPNG_REALLOC(output_buffer, output_buffer_size);
+        if (output_buffer_shrunk != NULL) output_buffer = output_buffer_shrunk;
+
+        *output = output_buffer;
+        *output_size = (int)output_buffer_size;
+    }
+    else RPNG_FREE(output_buffer);
+
+    return result;
+}
+
+// Save multiple images to files, memory buffers or callback, distributed between threads (if OpenMP enabled)
+// NOTE: Every thread keeps its own compression context (compressor state and filtering buffer),
+// reused for all the images it saves
+static int rpng_save_images(const char **filenames, rpng_image *images, int count, char **outputs, int *output_sizes, rpng_save_callback callback, void *user_data, int thread_count)
+{
+    int saved = 0;
+
+    if ((images == NULL) || (count <= 0)) return saved;
+
+#if defined(_OPENMP)
+    if (thread_count <= 0) thread_count = omp_get_max_threads();
+
+    #pragma omp parallel num_threads(thread_count) reduction(+:saved) if (count > 1)
+#else
+    (void)thread_count;
+#endif
+    {
+        rpng_deflate_context context = { 0 };   // Compression context, per thread
+
+#if defined(_OPENMP)
+        #pragma omp for schedule(dynamic, 1)
+#endif
+        for (int i = 0; i < count; i++)
+        {
+            if (filenames != NULL)
             {
-                memcpy(idata_buffer + 4 + idata_buffer_size, buffer_ptr + 8, chunk_size);
-                idata_buffer_size += chunk_size;
+                // PNG data pieces are written directly to file, PNG data is not joined
+                images[i].result = rpng_save_image_data(&context, images[i].data, images[i].width, images[i].height, images[i].color_channels, images[i].bit_depth, NULL, NULL, filenames[i], NULL, 0, NULL);
             }
             else
             {
-                memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
-                output_buffer_size += (4 + 4 + chunk_size + 4);
+                char *output = NULL;
+                int output_size = 0;
+
+                images[i].result = rpng_save_image_data_to_memory(&context, images[i].data, images[i].width, images[i].height, images[i].color_channels, images[i].bit_depth, NULL, NULL, &output, &output_size);
+
+                if (callback != NULL)
+                {
+#if defined(_OPENMP)
+                    #pragma omp critical (rpng_save_callback)
+#endif
+                    callback(user_data, i, output, output_size, images[i].result);
+
+                    RPNG_FREE(output);
+                }
+                else
+                {
+                    outputs[i] = output;
+                    if (output_sizes != NULL) output_sizes[i] = output_size;
+                }
+            }
+
+            if (images[i].result == RPNG_SUCCESS) saved++;
+        }
+
+        rpng_deflate_context_close(&context);
+    }
+
+    return saved;
+}
+
+// Encoder compressed data writer, compressed data is accumulated into IDAT chunks
+//  - Returns non-zero to stop compression if chunk could not be written
+static int rpng_encoder_write(void *user_data, const unsigned char *data, int size)
+{
+    rpng_encoder *encoder = (rpng_encoder *)user_data;
+
+    while (size > 0)
+    {
+        int count = RPNG_IDAT_CHUNK_SIZE - encoder->chunk_fill;
+        if (count > size) count = size;
+
+        memcpy(encoder->chunk + 8 + encoder->chunk_fill, data, count);
+        encoder->chunk_fill += count;
+        data += count;
+        size -= count;
+
+        if ((encoder->chunk_fill == RPNG_IDAT_CHUNK_SIZE) && !rpng_encoder_write_chunk(encoder)) return 1;
+    }
+
+    return 0;
+}
+
+// Encoder compressed data writer for codec streams
+//  - Returns false to stop compression if chunk could not be written
+static bool rpng_encoder_write_codec(void *user_data, const char *data, int size)
+{
+    return (rpng_encoder_write(user_data, (const unsigned char *)data, size) == 0);
+}
+
+// Write encoder current IDAT chunk to callback
+static bool rpng_encoder_write_chunk(rpng_encoder *encoder)
+{
+    unsigned int length = swap_endian(encoder->chunk_fill);
+    memcpy(encoder->chunk, &length, 4);
+    memcpy(encoder->chunk + 4, "IDAT", 4);
+    unsigned int crc = swap_endian(compute_crc32(encoder->chunk + 4, 4 + encoder->chunk_fill));
+    memcpy(encoder->chunk + 8 + encoder->chunk_fill, &crc, 4);
+
+    bool result = encoder->callback(encoder->user_data, (const char *)encoder->chunk, encoder->chunk_fill + 12);
+    encoder->chunk_fill = 0;
+
+    return result;
+}
+
+// Close encoder, all encoder memory is freed
+static void rpng_encoder_close(rpng_encoder *encoder)
+{
+    RPNG_FREE(encoder->row_previous);
+    RPNG_FREE(encoder->row_filtered);
+    // NOTE: Stream buffers are already freed if compression ended
+    if (encoder->stream != NULL) zsdeflate_free(encoder->stream);
+    sdefl_destroy(encoder->sde);
+    RPNG_FREE(encoder->stream);
+    // NOTE: Codec stream is only available if compression was not ended
+    if (encoder->codec_stream != NULL) rpng_codec_custom.compress_end(encoder->codec_stream, false);
+    RPNG_FREE(encoder->data_filtered);
+    RPNG_FREE(encoder->chunk);
+    RPNG_FREE(encoder);
+}
+
+// Load image data from memory buffer into image
+//  - Decoder context can be provided to reuse its memory between images, if NULL a temporal one is used
+//  - Image data is converted to output format (RPNG_OUTPUT_* flags), image info returns output channels and bit depth
+//  - Image info is filled if IHDR chunk is valid, even if image data can not be loaded
+//  - Returns loading result: RPNG_SUCCESS or error code
+static int rpng_load_image_data(rpng_row_decoder *context, const char *buffer, int output_format, rpng_image *image)
+{
+    int result = RPNG_SUCCESS;
+    rpng_chunk_IHDR image_info = { 0 };
+
+    memset(image, 0, sizeof(rpng_image));
+
+    if (!rpng_read_image_info(buffer, &image_info)) return RPNG_ERROR_INVALID_DATA;
+
+    image->width = swap_endian(image_info.width);
+    image->height = swap_endian(image_info.height);
+    rpng_get_output_format(&image_info, output_format, &image->color_channels, &image->bit_depth);   // NOTE: Indexed returns 1 channel containing 8-bit indexed data, if not expanded
+
+    // NOTE: Image data size is computed in size_t, checking overflow
+    size_t data_size = rpng_get_image_data_size(image->width, image->height, image->color_channels*image->bit_depth);
+
+    if (data_size > 0) image->data = (char *)RPNG_MALLOC(data_size);
+
+    if (image->data != NULL)
+    {
+        // Decode scanlines directly into output image data, no intermediate buffers required
+        // NOTE: Interlaced scanlines are scattered into image data once every pass scanline is decoded
+        if (!rpng_decode_image_data(context, buffer, &image_info, output_format, image_info.interlace? rpng_store_row_interlaced : rpng_store_row, image->data))
+        {
+            RPNG_LOG("WARNING: IDAT image data decompression failed\n");
+            RPNG_FREE(image->data);
+            image->data = NULL;
+            result = RPNG_ERROR_INVALID_DATA;
+        }
+    }
+    else
+    {
+        RPNG_LOG("WARNING: Failed to allocate memory for image data\n");
+        result = RPNG_ERROR_MEMORY_ALLOC;
+    }
+
+    return result;
+}
+
+// Load multiple images from files or memory buffers, distributed between threads (if OpenMP enabled)
+// NOTE: Every thread keeps its own decoder context, reused for all the images it loads,
+// files are loaded by the same thread decoding them, so files reading overlaps other images decoding
+static int rpng_load_images(const char **sources, bool sources_are_files, int count, rpng_image *images, int thread_count)
+{
+    int loaded = 0;
+
+    if ((sources == NULL) || (images == NULL) || (count <= 0)) return loaded;
+
+#if defined(_OPENMP)
+    if (thread_count <= 0) thread_count = omp_get_max_threads();
+
+    #pragma omp parallel num_threads(thread_count) reduction(+:loaded) if (count > 1)
+#else
+    (void)thread_count;
+#endif
+    {
+        rpng_row_decoder decoder = { 0 };   // Decoder context, per thread
+
+#if defined(_OPENMP)
+        #pragma omp for schedule(dynamic, 1)
+#endif
+        for (int i = 0; i < count; i++)
+        {
+            if (sources_are_files)
+            {
+                size_t file_size = 0;
+                char *file_data = load_file_to_buffer(sources[i], &file_size);
+
+                if (file_data != NULL)
+                {
+                    images[i].result = rpng_load_image_data(&decoder, file_data, RPNG_OUTPUT_DEFAULT, &images[i]);
+                    RPNG_FREE(file_data);
+                }
+                else
+                {
+                    memset(&images[i], 0, sizeof(rpng_image));
+                    images[i].result = RPNG_ERROR_FILE_OPEN;
+                }
+            }
+            else images[i].result = rpng_load_image_data(&decoder, sources[i], RPNG_OUTPUT_DEFAULT, &images[i]);
+
+            if (images[i].result == RPNG_SUCCESS) loaded++;
+        }
+
+        rpng_row_decoder_close(&decoder);
+    }
+
+    return loaded;
+}
+
+// Check image info (IHDR) values are valid
+// NOTE: Allowed bit depths depend on color type
+static bool rpng_check_image_info(const rpng_chunk_IHDR *image_info)
+{
+    bool result = false;
+
+    int width = swap_endian(image_info->width);
+    int height = swap_endian(image_info->height);
+    int bit_depth = image_info->bit_depth;
+
+    if ((width > 0) && (height > 0) && (image_info->compression == 0) && (image_info->filter == 0) && (image_info->interlace <= 1))
+    {
+        switch (image_info->color_type)
+        {
+            case 0: result = (bit_depth == 1) || (bit_depth == 2) || (bit_depth == 4) || (bit_depth == 8) || (bit_depth == 16); break; // Grayscale
+            case 3: result = (bit_depth == 1) || (bit_depth == 2) || (bit_depth == 4) || (bit_depth == 8); break;   // Indexed
+            case 2:     // RGB
+            case 4:     // Gray + Alpha
+            case 6: result = (bit_depth == 8) || (bit_depth == 16); break;  // RGBA
+            default: break;
+        }
+    }
+
+    return result;
+}
+
+// Read image info from IHDR chunk, it must be the first chunk and data size is always 13 bytes
+// NOTE: Returns true if image info is valid
+static bool rpng_read_image_info(const char *buffer, rpng_chunk_IHDR *image_info)
+{
+    bool result = false;
+
+    if ((buffer != NULL) && (memcmp(buffer, png_signature, 8) == 0))  // Check valid PNG file
+    {
+        const char *chunk_info = buffer + 8;
+
+        if ((memcmp(chunk_info + 4, "IHDR", 4) == 0) && (swap_endian(((int *)chunk_info)[0]) == 13))
+        {
+            memcpy(image_info, chunk_info + 8, 13);
+            result = rpng_check_image_info(image_info);
+        }
+    }
+
+    return result;
+}
+
+// Get color channels for a color type, indexed images return 1 channel (index)
+// NOTE: Returns 0 if color type is not valid
+static int rpng_get_color_type(int color_channels)
+{
+    int color_type = -1;
+
+    switch (color_channels)
+    {
+        case 1: color_type = 0; break;      // Grayscale
+        case 2: color_type = 4; break;      // Gray + Alpha
+        case 3: color_type = 2; break;      // RGB
+        case 4: color_type = 6; break;      // RGBA
+        default: break;
+    }
+
+    return color_type;
+}
+
+// Get color channels from color type
+static int rpng_get_color_channels(int color_type)
+{
+    int color_channels = 0;
+
+    switch (color_type)
+    {
+        case 0: color_channels = 1; break;  // Pixel format: 0-Grayscale
+        case 4: color_channels = 2; break;  // Pixel format: 4-GrayAlpha
+        case 2: color_channels = 3; break;  // Pixel format: 2-RGB
+        case 6: color_channels = 4; break;  // Pixel format: 6-RGBA
+        case 3: color_channels = 1; break;  // Pixel format: 3-Indexed
+        default: break;
+    }
+
+    return color_channels;
+}
+
+// Get image data size in bytes (scanlines are byte aligned), checking arithmetic overflow
+// NOTE: Returns 0 if size is not valid or it can not be represented in a size_t
+static size_t rpng_get_image_data_size(int width, int height, int bits_per_pixel)
+{
+    size_t size = 0;
+
+    if ((width > 0) && (height > 0) && (bits_per_pixel > 0))
+    {
+        size_t row_size = ((size_t)width*bits_per_pixel + 7)/8;
+
+        if (row_size <= ((size_t)-1)/(size_t)height) size = row_size*height;
+    }
+
+    return size;
+}
+
+// Get filtered image data size: every scanline (every pass scanline if interlaced) plus filter type byte
+// NOTE: Returns 0 if provided values are not valid or size overflows
+static size_t rpng_get_filtered_data_size(int width, int height, int bits_per_pixel, bool interlace)
+{
+    size_t size = 0;
+
+    if ((width <= 0) || (height <= 0)) return size;
+
+    for (int pass = 0; pass < (interlace? 7 : 1); pass++)
+    {
+        int pass_width = width;
+        int pass_height = height;
+        if (interlace) rpng_get_pass_size(width, height, pass, &pass_width, &pass_height);
+
+        if ((pass_width == 0) || (pass_height == 0)) continue;
+
+        size_t pass_size = rpng_get_image_data_size(pass_width, pass_height, bits_per_pixel);
+        if ((pass_size == 0) || ((size + pass_size + pass_height) < size)) return 0;
+
+        size += pass_size + pass_height;
+    }
+
+    return size;
+}
+
+// Get Adam7 pass size in pixels, 0 if pass contains no pixels
+static void rpng_get_pass_size(int width, int height, int pass, int *pass_width, int *pass_height)
+{
+    *pass_width = (width > adam7_x_start[pass])? (width - adam7_x_start[pass] + adam7_x_step[pass] - 1)/adam7_x_step[pass] : 0;
+    *pass_height = (height > adam7_y_start[pass])? (height - adam7_y_start[pass] + adam7_y_step[pass] - 1)/adam7_y_step[pass] : 0;
+}
+
+// Get image data format provided by decoder for output format conversion flags (RPNG_OUTPUT_*)
+// NOTE: Bit depths 1/2/4 are unpacked to 8 bit
+static void rpng_get_output_format(const rpng_chunk_IHDR *image_info, int output_format, int *color_channels, int *bit_depth)
+{
+    *color_channels = rpng_get_color_channels(image_info->color_type);
+    *bit_depth = (image_info->bit_depth < 8)? 8 : image_info->bit_depth;
+
+    if ((*color_channels > 0) && (output_format & (RPNG_OUTPUT_RGBA | RPNG_OUTPUT_BGRA))) *color_channels = 4;
+    if ((*bit_depth == 16) && (output_format & RPNG_OUTPUT_8BIT)) *bit_depth = 8;
+}
+
+// Find first chunk of requested type in memory buffer
+// NOTE: Returns a pointer to the chunk (length field) or NULL if not found
+static const char *rpng_find_chunk(const char *buffer, const char *chunk_type)
+{
+    const char *chunk = NULL;
+
+    if ((buffer != NULL) && (memcmp(buffer, png_signature, 8) == 0))  // Check valid PNG file
+    {
+        const char *buffer_ptr = buffer + 8;
+
+        while (true)
+        {
+            if (memcmp(buffer_ptr + 4, chunk_type, 4) == 0) { chunk = buffer_ptr; break; }
+            if (memcmp(buffer_ptr + 4, "IEND", 4) == 0) break;
+
+            buffer_ptr += (4 + 4 + swap_endian(((int *)buffer_ptr)[0]) + 4);   // Move pointer to next chunk
+        }
+    }
+
+    return chunk;
+}
+
+// Get image data (IDAT chunks data) from memory buffer
+// NOTE: If there is only one IDAT chunk, data is not copied and returned pointer references buffer data,
+// in case of multiple IDAT chunks, data is concatenated in a new buffer (image_data_copy = true), to be freed by user
+static const char *rpng_get_image_data(const char *buffer, size_t *image_data_size, bool *image_data_copy)
+{
+    const char *image_data = NULL;
+    int idat_count = 0;
+    size_t idat_size = 0;
+
+    *image_data_size = 0;
+    *image_data_copy = false;
+
+    const char *buffer_ptr = rpng_find_chunk(buffer, "IDAT");
+
+    if (buffer_ptr != NULL)
+    {
+        image_data = buffer_ptr + 8;
+
+        // Multiple IDATs chunks must be consecutive
+        while (memcmp(buffer_ptr + 4, "IDAT", 4) == 0)
+        {
+            unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+            idat_size += chunk_size;
+            idat_count++;
+
+            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+        }
+
+        if (idat_count > 1)
+        {
+            // NOTE: Decompressor never reads past input end, no extra bytes required
+            char *idat_data_concat = (char *)RPNG_MALLOC(idat_size);
+
+            if (idat_data_concat != NULL)
+            {
+                size_t idat_data_concat_size = 0;
+                buffer_ptr = image_data - 8;
+
+                for (int i = 0; i < idat_count; i++)
+                {
+                    unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+                    memcpy(idat_data_concat + idat_data_concat_size, buffer_ptr + 8, chunk_size);
+                    idat_data_concat_size += chunk_size;
+
+                    buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
+                }
+
+                *image_data_copy = true;
+            }
+
+            image_data = idat_data_concat;
+        }
+
+        if (image_data != NULL) *image_data_size = idat_size;
+    }
+
+    return image_data;
+}
+
+// Decode image data (all IDAT chunks) from memory buffer, scanlines are provided to rows processor
+//  - Decoder context can be provided to reuse its memory between images, if NULL a temporal one is used
+//  - Scanlines are converted to output format (RPNG_OUTPUT_* flags) before being provided to rows processor
+//  - Returns true if all scanlines have been decoded
+static bool rpng_decode_image_data(rpng_row_decoder *context, const char *buffer, const rpng_chunk_IHDR *image_info, int output_format, bool (*process_row)(rpng_row_decoder *decoder, const unsigned char *row), void *user_data)
+{
+    bool result = false;
+    size_t image_data_size = 0;
+    bool image_data_copy = false;
+    const char *image_data = rpng_get_image_data(buffer, &image_data_size, &image_data_copy);
+
+    // WARNING: Compressed image data size is limited to int range by decompressor
+    if ((image_data != NULL) && (image_data_size <= 0x7fffffff))
+    {
+        rpng_row_decoder temp_decoder = { 0 };
+        rpng_row_decoder *decoder = (context != NULL)? context : &temp_decoder;
+        decoder->process_row = process_row;
+        decoder->user_data = user_data;
+        decoder->output_format = output_format;
+
+        // Indexed image data expanded to RGBA/BGRA requires palette colors (PLTE chunk)
+        bool palette_valid = true;
+        if ((image_info->color_type == 3) && (output_format & (RPNG_OUTPUT_RGBA | RPNG_OUTPUT_BGRA))) palette_valid = rpng_read_palette_lut(buffer, output_format, decoder->palette_lut);
+
+        if (palette_valid && rpng_row_decoder_init(decoder, image_info)) result = rpng_row_decoder_decode(decoder, image_data, (int)image_data_size);
+
+        if (context == NULL) rpng_row_decoder_close(&temp_decoder);
+    }
+    else if (image_data != NULL) RPNG_LOG("WARNING: IDAT image data too big to be decompressed\n");
+
+    if (image_data_copy) RPNG_FREE((char *)image_data);
+
+    return result;
+}
+
+// Rows processor: store unfiltered scanline into image data (provided as user data)
+// NOTE: Image data is not interlaced, scanlines are stored consecutively
+static bool rpng_store_row(rpng_row_decoder *decoder, const unsigned char *row)
+{
+    memcpy((char *)decoder->user_data + (size_t)decoder->row*decoder->row_output_size, row, decoder->row_output_size);
+
+    return true;
+}
+
+// Rows processor: store unfiltered interlaced scanline pixels into their image positions (image data provided as user data)
+static bool rpng_store_row_interlaced(rpng_row_decoder *decoder, const unsigned char *row)
+{
+    rpng_scatter_row((unsigned char *)decoder->user_data, decoder, row);
+
+    return true;
+}
+
+// Rows processor: store unfiltered scanline into image data, image data is provided to user pass callback once every pass is decoded
+static bool rpng_progressive_row(rpng_row_decoder *decoder, const unsigned char *row)
+{
+    bool result = true;
+    rpng_pass_callback_data *callback_data = (rpng_pass_callback_data *)decoder->user_data;
+
+    if (decoder->interlace) rpng_scatter_row((unsigned char *)callback_data->data, decoder, row);
+    else memcpy(callback_data->data + (size_t)decoder->row*decoder->row_output_size, row, decoder->row_output_size);
+
+    if (decoder->row == (decoder->pass_height - 1))
+    {
+        // NOTE: If following passes contain no pixels (small images), image data is complete (reported as pass 7)
+        int pass = decoder->interlace? (decoder->pass + 1) : 7;
+        int next = pass;
+        while ((next < 7) && ((decoder->width <= adam7_x_start[next]) || (decoder->height <= adam7_y_start[next]))) next++;
+        if (next == 7) pass = 7;
+
+        result = callback_data->callback(callback_data->user_data, callback_data->data, pass);
+    }
+
+    return result;
+}
+
+// Rows processor: store unfiltered scanline pixels inside region into region image data (provided as user data)
+// NOTE: Returns false to stop decoding once all region scanlines are stored
+static bool rpng_store_region_row(rpng_row_decoder *decoder, const unsigned char *row)
+{
+    rpng_region_data *region = (rpng_region_data *)decoder->user_data;
+    int pixel_size = decoder->output_pixel_size;
+    int y = decoder->row;
+    int x_start = 0;
+    int x_step = 1;
+
+    if (decoder->interlace)
+    {
+        y = adam7_y_start[decoder->pass] + decoder->row*adam7_y_step[decoder->pass];
+        x_start = adam7_x_start[decoder->pass];
+        x_step = adam7_x_step[decoder->pass];
+    }
+
+    if ((y >= region->y) && (y < (region->y + region->height)))
+    {
+        unsigned char *output = (unsigned char *)region->data + (size_t)(y - region->y)*region->width*pixel_size;
+
+        if (x_step == 1) memcpy(output, row + (size_t)region->x*pixel_size, (size_t)region->width*pixel_size);
+        else
+        {
+            // First pass pixel inside region: x_start + i*x_step >= region->x
+            int i = (region->x > x_start)? (region->x - x_start + x_step - 1)/x_step : 0;
+
+            for (int x = x_start + i*x_step; (x < (region->x + region->width)) && (i < decoder->pass_width); i++, x += x_step)
+            {
+                memcpy(output + (size_t)(x - region->x)*pixel_size, row + (size_t)i*pixel_size, pixel_size);
             }
+        }
+    }
+
+    // NOTE: Adam7 image scanlines are completed by last pass (odd scanlines), even scanlines were completed by previous pass
+    if (!decoder->interlace || (decoder->pass == 6))
+    {
+        if ((y + (decoder->interlace? 2 : 1)) >= (region->y + region->height)) region->complete = true;
+    }
+
+    return !region->complete;
+}
+
+// Scatter one Adam7 pass scanline pixels into its image scanline
+// NOTE: Copy kernels are specialized by pixel size (constant size copies), last pass scanlines are contiguous
+static void rpng_scatter_row(unsigned char *image_data, const rpng_row_decoder *decoder, const unsigned char *row)
+{
+    int pass = decoder->pass;
+    int pixel_size = decoder->output_pixel_size;   // NOTE: Bit depths 1/2/4 are unpacked, 1 byte per pixel
+    int count = decoder->pass_width;
+    size_t y = (size_t)adam7_y_start[pass] + (size_t)decoder->row*adam7_y_step[pass];
+    size_t step = (size_t)adam7_x_step[pass]*pixel_size;
+    unsigned char *output = image_data + y*decoder->width*pixel_size + (size_t)adam7_x_start[pass]*pixel_size;
+
+    if (adam7_x_step[pass] == 1) memcpy(output, row, (size_t)count*pixel_size);
+    else
+    {
+        switch (pixel_size)
+        {
+            case 1: for (int i = 0; i < count; i++) output[i*step] = row[i]; break;
+            case 2: for (int i = 0; i < count; i++) memcpy(output + i*step, row + i*2, 2); break;
+            case 3: for (int i = 0; i < count; i++) memcpy(output + i*step, row + i*3, 3); break;
+            case 4: for (int i = 0; i < count; i++) memcpy(output + i*step, row + i*4, 4); break;
+            case 6: for (int i = 0; i < count; i++) memcpy(output + i*step, row + i*6, 6); break;
+            case 8: for (int i = 0; i < count; i++) memcpy(output + i*step, row + i*8, 8); break;
+            default: break;
+        }
+    }
+}
 
-            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
-            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+// Rows processor: provide unfiltered scanline to user rows callback
+static bool rpng_callback_row(rpng_row_decoder *decoder, const unsigned char *row)
+{
+    rpng_row_callback_data *callback_data = (rpng_row_callback_data *)decoder->user_data;
+
+    return callback_data->callback(callback_data->user_data, (const char *)row, decoder->row);
+}
+
+// Start decoding one pass of image data (only one pass if not interlaced)
+// NOTE: Adam7 passes with no pixels are skipped, they contain no scanlines
+static void rpng_row_decoder_start_pass(rpng_row_decoder *decoder, int pass)
+{
+    decoder->row = 0;
+    decoder->row_fill = 0;
+    decoder->complete = true;
+
+    for (; pass < (decoder->interlace? 7 : 1); pass++)
+    {
+        if (decoder->interlace) rpng_get_pass_size(decoder->width, decoder->height, pass, &decoder->pass_width, &decoder->pass_height);
+        else
+        {
+            decoder->pass_width = decoder->width;
+            decoder->pass_height = decoder->height;
         }
 
-        // Write IDAT combined chunk
-        unsigned int idata_buffer_size_be = swap_endian(idata_buffer_size);
-        memcpy(output_buffer + output_buffer_size, &idata_buffer_size_be, 4);
-        memcpy(output_buffer + output_buffer_size + 4, idata_buffer, 4 + idata_buffer_size);
-        unsigned int crc = compute_crc32((unsigned char *)idata_buffer, 4 + idata_buffer_size);
-        crc = swap_endian(crc);
-        memcpy(output_buffer + output_buffer_size + 4 + 4 + idata_buffer_size, &crc, 4);
-        RPNG_FREE(idata_buffer);
+        if ((decoder->pass_width > 0) && (decoder->pass_height > 0))
+        {
+            decoder->pass = pass;
+            decoder->row_size = (int)(((long long)decoder->pass_width*decoder->bits_per_pixel + 7)/8);
+            decoder->row_output_size = decoder->pass_width*decoder->output_pixel_size;
+            decoder->complete = false;
+            break;
+        }
+    }
+}
+
+// Init image data scanlines decoder, scanlines memory is allocated
+// NOTE: Decoder can be reused for multiple images, memory is only reallocated if bigger scanlines are required
+static bool rpng_row_decoder_init(rpng_row_decoder *decoder, const rpng_chunk_IHDR *image_info)
+{
+    int color_channels = rpng_get_color_channels(image_info->color_type);
+    int output_channels = 0;
+    int output_bit_depth = 0;
+    rpng_get_output_format(image_info, decoder->output_format, &output_channels, &output_bit_depth);
+
+    decoder->width = swap_endian(image_info->width);
+    decoder->height = swap_endian(image_info->height);
+    decoder->bits_per_pixel = color_channels*image_info->bit_depth;
+    decoder->pixel_size = (decoder->bits_per_pixel >= 8)? decoder->bits_per_pixel/8 : 1;
+    decoder->color_channels = color_channels;
+    decoder->bit_depth = (image_info->bit_depth < 8)? 8 : image_info->bit_depth;
+    decoder->interlace = image_info->interlace;
+    decoder->unpack_depth = (image_info->bit_depth < 8)? image_info->bit_depth : 0;
+    decoder->indexed = (image_info->color_type == 3);
+    decoder->output_format = decoder->indexed? (decoder->output_format & (RPNG_OUTPUT_RGBA | RPNG_OUTPUT_BGRA)) : rpng_get_row_conversion(color_channels, decoder->bit_depth, decoder->output_format);
+    decoder->output_pixel_size = output_channels*output_bit_depth/8;
+    decoder->failed = false;
+
+    // WARNING: Scanline size in bytes must fit in an int
+    // NOTE: Bit depths 1/2/4 are unpacked to 1 byte per pixel, scanlines capacity must fit unpacked and converted data
+    long long row_size = ((long long)decoder->width*decoder->bits_per_pixel + 7)/8;
+    if (row_size < (long long)decoder->width*decoder->output_pixel_size) row_size = (long long)decoder->width*decoder->output_pixel_size;
+    if ((color_channels == 0) || (decoder->width <= 0) || (decoder->height <= 0) || (row_size >= 0x7fffffff)) return false;
+
+    if ((decoder->row_current == NULL) || (decoder->row_capacity < (row_size + 1)))
+    {
+        RPNG_FREE(decoder->row_current);
+        RPNG_FREE(decoder->row_previous);
+        RPNG_FREE(decoder->row_unpacked);
+        RPNG_FREE(decoder->row_converted);
+        decoder->row_unpacked = NULL;
+        decoder->row_converted = NULL;
+
+        decoder->row_capacity = (int)row_size + 1;
+        decoder->row_current = (unsigned char *)RPNG_MALLOC(decoder->row_capacity);
+        decoder->row_previous = (unsigned char *)RPNG_MALLOC(decoder->row_capacity);
+
+        if ((decoder->row_current == NULL) || (decoder->row_previous == NULL))
+        {
+            rpng_row_decoder_close(decoder);
+            return false;
+        }
+    }
+
+    if (decoder->unpack_depth > 0)
+    {
+        if (decoder->row_unpacked == NULL) decoder->row_unpacked = (unsigned char *)RPNG_MALLOC(decoder->row_capacity);
+        if (decoder->row_unpacked == NULL)
+        {
+            rpng_row_decoder_close(decoder);
+            return false;
+        }
 
-        output_buffer_size += (idata_buffer_size + 12);
+        // Unpacking lookup table: every packed byte expanded to 8/4/2 pixels (first pixel in most significant bits)
+        // NOTE: Grayscale values are scaled to 8 bit range, indexed values are kept as palette indexes
+        int pixels_per_byte = 8/decoder->unpack_depth;
+        int mask = (1 << decoder->unpack_depth) - 1;
+        int scale = (image_info->color_type == 0)? 255/mask : 1;
 
-        // Write IEND chunk
-        memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + 4);
-        output_buffer_size += 12;
+        for (int value = 0; value < 256; value++)
+        {
+            for (int i = 0; i < pixels_per_byte; i++)
+            {
+                decoder->unpack_lut[value*8 + i] = (unsigned char)(((value >> (8 - decoder->unpack_depth*(i + 1))) & mask)*scale);
+            }
+        }
+    }
 
-        // Resize output buffer
-        char *output_buffer_sized = (char *)RPNG_REALLOC(output_buffer, output_buffer_size);
-        if (output_buffer_sized != NULL) output_buffer = output_buffer_sized;
+    if (decoder->output_format != 0)
+    {
+        if (decoder->row_converted == NULL) decoder->row_converted = (unsigned char *)RPNG_MALLOC(decoder->row_capacity);
+        if (decoder->row_converted == NULL)
+        {
+            rpng_row_decoder_close(decoder);
+            return false;
+        }
     }
 
-    *output_size = output_buffer_size;
-    return output_buffer;
+    rpng_row_decoder_start_pass(decoder, 0);
+
+    return true;
 }
 
-// Split one IDAT chunk into multiple ones
-char *rpng_chunk_split_image_data_from_memory(char *buffer, int split_size, int *output_size)
+// Close image data scanlines decoder, scanlines and window memory is freed
+static void rpng_row_decoder_close(rpng_row_decoder *decoder)
 {
-    char *buffer_ptr = (char *)buffer;
-    char *output_buffer = NULL;
-    int output_buffer_size = 0;
+    RPNG_FREE(decoder->row_current);
+    RPNG_FREE(decoder->row_previous);
+    RPNG_FREE(decoder->row_unpacked);
+    RPNG_FREE(decoder->row_converted);
+    RPNG_FREE(decoder->window);
+    decoder->row_current = NULL;
+    decoder->row_previous = NULL;
+    decoder->row_unpacked = NULL;
+    decoder->row_converted = NULL;
+    decoder->window = NULL;
+    decoder->row_capacity = 0;
+}
 
-    if ((buffer_ptr != NULL) && (memcmp(buffer_ptr, png_signature, 8) == 0))  // Check valid PNG file
-    {
-        char *idata_split_buffer = (char *)RPNG_CALLOC(split_size + 12, 1);    // Output buffer allocation
+// Receive decompressed image data, scanlines are unfiltered and processed when completed
+// NOTE: Returns non-zero to stop decompression
+static int rpng_row_decoder_write(void *user_data, const unsigned char *data, int size)
+{
+    rpng_row_decoder *decoder = (rpng_row_decoder *)user_data;
 
-        output_buffer = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, 1);  // Output buffer allocation
+    while ((size > 0) && !decoder->failed)
+    {
+        // WARNING: More data than expected scanlines
+        if (decoder->complete) { decoder->failed = true; break; }
 
-        memcpy(output_buffer, png_signature, 8);    // Copy PNG signature
-        output_buffer_size += 8;
-        buffer_ptr += 8;       // Move pointer after signature
+        int length = decoder->row_size + 1 - decoder->row_fill;
+        if (length > size) length = size;
 
-        unsigned int chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+        memcpy(decoder->row_current + decoder->row_fill, data, length);
+        decoder->row_fill += length;
+        data += length;
+        size -= length;
 
-        while (memcmp(buffer_ptr + 4, "IEND", 4) != 0)         // While IEND chunk not reached
+        if (decoder->row_fill == (decoder->row_size + 1))
         {
-            // If IDAT chunk, split into multiple sized chunks
-            if ((memcmp(buffer_ptr + 4, "IDAT", 4) == 0) && (chunk_size > (unsigned int)split_size))
-            {
-                // Split chunk into pieces!
-                unsigned int chunk_remain_size = chunk_size;
-                char *buffer_ptr_offset = buffer_ptr + 4 + 4;
+            // First byte of every scanline defines the filter type
+            int filter = decoder->row_current[0];
+            if (filter > 4) { decoder->failed = true; break; }
 
-                while (chunk_remain_size > (unsigned int)split_size)
-                {
-                    unsigned int split_size_be = swap_endian(split_size);
-                    memcpy(idata_split_buffer, &split_size_be, 4);
-                    memcpy(idata_split_buffer + 4, "IDAT", 4);
-                    memcpy(idata_split_buffer + 4 + 4, buffer_ptr_offset, split_size);
-                    unsigned int crc = compute_crc32((unsigned char *)(idata_split_buffer + 4), 4 + split_size);
-                    crc = swap_endian(crc);
-                    memcpy(idata_split_buffer + 4 + 4 + split_size, &crc, 4);
+            rpng_unfilter_row(decoder->row_current + 1, (decoder->row > 0)? decoder->row_previous + 1 : NULL, filter, decoder->row_size, decoder->pixel_size);
 
-                    chunk_remain_size -= split_size;
-                    buffer_ptr_offset += split_size;
+            if (decoder->process_row != NULL)
+            {
+                // Bit depths 1/2/4 are unpacked and scanline is converted to output format while unfiltered scanline is still in cache
+                // NOTE: Unfiltered scanline is kept unmodified for next scanline unfiltering
+                const unsigned char *row = decoder->row_current + 1;
 
-                    memcpy(output_buffer + output_buffer_size, idata_split_buffer, split_size + 12);
-                    output_buffer_size += (split_size + 12);
+                if (decoder->unpack_depth > 0)
+                {
+                    rpng_unpack_row(decoder->row_unpacked, row, decoder->pass_width, decoder->unpack_depth, decoder->unpack_lut);
+                    row = decoder->row_unpacked;
                 }
 
-                // Save last IDAT chunk piece
-                unsigned int chunk_remain_size_be = swap_endian(chunk_remain_size);
-                memcpy(idata_split_buffer, &chunk_remain_size_be, 4);
-                memcpy(idata_split_buffer + 4, "IDAT", 4);
-                memcpy(idata_split_buffer + 4 + 4, buffer_ptr_offset, chunk_remain_size);
-                unsigned int crc = compute_crc32((unsigned char *)(idata_split_buffer + 4), 4 + chunk_remain_size);
-                crc = swap_endian(crc);
-                memcpy(idata_split_buffer + 4 + 4 + chunk_remain_size, &crc, 4);
+                if (decoder->output_format != 0)
+                {
+                    if (decoder->indexed) rpng_expand_row(decoder->row_converted, row, decoder->pass_width, decoder->palette_lut);
+                    else rpng_convert_row(decoder->row_converted, row, decoder->pass_width, decoder->color_channels, decoder->bit_depth, decoder->output_format);
+                    row = decoder->row_converted;
+                }
 
-                memcpy(output_buffer + output_buffer_size, idata_split_buffer, chunk_remain_size + 12);
-                output_buffer_size += (chunk_remain_size + 12);
+                if (!decoder->process_row(decoder, row)) return 1;
             }
-            else
+
+            unsigned char *row_temp = decoder->row_previous;
+            decoder->row_previous = decoder->row_current;
+            decoder->row_current = row_temp;
+            decoder->row_fill = 0;
+            decoder->row++;
+
+            if (decoder->row == decoder->pass_height) rpng_row_decoder_start_pass(decoder, decoder->pass + 1);
+        }
+    }
+
+    return decoder->failed? 1 : 0;
+}
+
+// Receive decompressed image data from codec streams, see rpng_row_decoder_write()
+//  - Returns false to stop decompression
+static bool rpng_row_decoder_write_codec(void *user_data, const char *data, int size)
+{
+    return (rpng_row_decoder_write(user_data, (const unsigned char *)data, size) == 0);
+}
+
+// Decompress image data (zlib stream) and decode all scanlines
+// NOTE: Decompressed data is never fully stored, only the deflate window is required
+// (custom codec without streaming decompression requires a temporal buffer for all image data)
+static bool rpng_row_decoder_decode(rpng_row_decoder *decoder, const char *image_data, int image_data_size)
+{
+    bool result = false;
+
+    // NOTE: Window is allocated once and kept until decoder is closed
+    if (rpng_codec_custom.decompress != NULL)
+    {
+        if (rpng_codec_custom.decompress_stream != NULL) result = rpng_codec_custom.decompress_stream(rpng_codec_custom.user_data, image_data, image_data_size, rpng_row_decoder_write_codec, decoder);
+        else
+        {
+            // Image data decompressed at once into a temporal buffer, scanlines processed from it
+            // NOTE: Capacity exceeds expected size by one byte, so more data than expected scanlines is detected
+            size_t data_size = rpng_get_filtered_data_size(decoder->width, decoder->height, decoder->bits_per_pixel, decoder->interlace != 0);
+            char *data = ((data_size > 0) && (data_size < 0x7fffffff))? (char *)RPNG_MALLOC(data_size + 1) : NULL;
+
+            if (data != NULL)
             {
-                memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + chunk_size + 4);  // Length + FOURCC + chunk_size + CRC32
-                output_buffer_size += (4 + 4 + chunk_size + 4);
+                int size = rpng_codec_custom.decompress(rpng_codec_custom.user_data, data, (int)data_size + 1, image_data, image_data_size);
+                result = (size > 0) && (rpng_row_decoder_write(decoder, (const unsigned char *)data, size) == 0);
             }
+            else RPNG_LOG("WARNING: Image data too big to be decompressed at once by codec\n");
 
-            buffer_ptr += (4 + 4 + chunk_size + 4);   // Move pointer to next chunk
-            chunk_size = swap_endian(((int *)buffer_ptr)[0]);
+            RPNG_FREE(data);
         }
 
-        RPNG_FREE(idata_split_buffer);
+        return result && decoder->complete && !decoder->failed;
+    }
 
-        // Write IEND chunk
-        memcpy(output_buffer + output_buffer_size, buffer_ptr, 4 + 4 + 4);
-        output_buffer_size += 12;
+    if (decoder->window == NULL) decoder->window = (unsigned char *)RPNG_MALLOC(3*SINFL_WIN_SIZ);
 
-        // Resize output buffer
-        char *output_buffer_sized = (char *)RPNG_REALLOC(output_buffer, output_buffer_size);
-        if (output_buffer_sized != NULL) output_buffer = output_buffer_sized;
+    if (decoder->window != NULL)
+    {
+        int status = zsinflate_stream(decoder->window, 3*SINFL_WIN_SIZ, image_data, image_data_size, rpng_row_decoder_write, decoder);
+        result = (status == 0) && decoder->complete && !decoder->failed;
     }
 
-    *output_size = output_buffer_size;
-    return output_buffer;
+    return result;
 }
 
-//----------------------------------------------------------------------------------
-// Module specific Functions Definition
-//----------------------------------------------------------------------------------
+// Unfilter one scanline in place, previous scanline is required unfiltered (NULL for first scanline)
+// REF: https://www.w3.org/TR/PNG/#9Filters
+static void rpng_unfilter_row(unsigned char *row, const unsigned char *previous, int filter, int size, int pixel_size)
+{
+    switch (filter)
+    {
+        case 0: break;      // Filter type 0: None
+        case 1:             // Filter type 1: Sub
+        {
+            for (int p = pixel_size; p < size; p++) row[p] += row[p - pixel_size];
+        } break;
+        case 2:             // Filter type 2: Up
+        {
+            if (previous != NULL) for (int p = 0; p < size; p++) row[p] += previous[p];
+        } break;
+        case 3:             // Filter type 3: Average
+        {
+            for (int p = 0; p < size; p++)
+            {
+                int a = (p >= pixel_size)? row[p - pixel_size] : 0;
+                int b = (previous != NULL)? previous[p] : 0;
+                row[p] += (unsigned char)((a + b)>>1);
+            }
+        } break;
+        case 4:             // Filter type 4: Paeth
+        {
+            for (int p = 0; p < size; p++)
+            {
+                int a = (p >= pixel_size)? row[p - pixel_size] : 0;
+                int b = (previous != NULL)? previous[p] : 0;
+                int c = ((previous != NULL) && (p >= pixel_size))? previous[p - pixel_size] : 0;
+                row[p] += rpng_paeth_predictor(a, b, c);
+            }
+        } break;
+        default: break;
+    }
+}
 
-// Prefilter and compress image data
-static char *rpng_deflate_image_data(const char *image_data, int image_data_size, int width, int height, int pixel_size, int *output_size, int forced_filter_type)
+// Unpack one scanline of 1/2/4 bit values into 8 bit values, every packed byte expanded using lookup table
+static void rpng_unpack_row(unsigned char *output, const unsigned char *row, int width, int bit_depth, const unsigned char *lut)
 {
-    char *idat_data = NULL;
+    int pixels_per_byte = 8/bit_depth;
+    int full_bytes = width/pixels_per_byte;
 
-    // Image data pre-processing to append filter type byte to every scanline
-    //int pixel_size = color_channels*(bit_depth/8);
-    int scanline_size = width*pixel_size;
-    unsigned int data_filtered_size = (scanline_size + 1)*height;   // Adding 1 byte per scanline filter
-    unsigned char *data_filtered = (unsigned char *)RPNG_CALLOC(data_filtered_size, 1);
+    // NOTE: Copy sizes are constant per bit depth, so copies are inlined by compiler
+    switch (bit_depth)
+    {
+        case 1: for (int i = 0; i < full_bytes; i++) memcpy(output + i*8, lut + row[i]*8, 8); break;
+        case 2: for (int i = 0; i < full_bytes; i++) memcpy(output + i*4, lut + row[i]*8, 4); break;
+        case 4: for (int i = 0; i < full_bytes; i++) memcpy(output + i*2, lut + row[i]*8, 2); break;
+        default: break;
+    }
 
-    int out = 0, x = 0, a = 0, b = 0, c = 0;
-    int sum_value[5] = { 0 };
-    int best_filter = 0;
+    // Last byte could be partially used
+    int remaining = width - full_bytes*pixels_per_byte;
+    if (remaining > 0) memcpy(output + full_bytes*pixels_per_byte, lut + row[full_bytes]*8, remaining);
+}
 
-    for (int y = 0; y < height; y++)
+// Pack one scanline of 8 bit values into 1/2/4 bit values, first pixel in most significant bits
+// NOTE: Values are masked to bit depth, unused bits of last byte are set to 0
+static void rpng_pack_row(unsigned char *output, const unsigned char *row, int width, int bit_depth)
+{
+    int pixels_per_byte = 8/bit_depth;
+    unsigned int mask = (1u << bit_depth) - 1;
+
+    for (int x = 0; x < width; x += pixels_per_byte)
+    {
+        unsigned int value = 0;
+        for (int i = 0; i < pixels_per_byte; i++) value = (value << bit_depth) | (((x + i) < width)? (row[x + i] & mask) : 0);
+
+        *output++ = (unsigned char)value;
+    }
+}
+
+// Get scanlines conversion required to provide output format (RPNG_OUTPUT_* flags), 0 if not required
+// NOTE: Conversions with no effect on image data format are removed
+static int rpng_get_row_conversion(int color_channels, int bit_depth, int output_format)
+{
+    int conversion = output_format & (RPNG_OUTPUT_RGBA | RPNG_OUTPUT_BGRA | RPNG_OUTPUT_PREMULTIPLY | RPNG_OUTPUT_8BIT | RPNG_OUTPUT_HOST_ENDIAN);
+
+    if ((color_channels == 4) && !(conversion & RPNG_OUTPUT_BGRA)) conversion &= ~RPNG_OUTPUT_RGBA;   // Already RGBA
+    if ((color_channels == 1) || (color_channels == 3)) conversion &= ~RPNG_OUTPUT_PREMULTIPLY;    // No alpha, opaque
+    if (bit_depth != 16) conversion &= ~(RPNG_OUTPUT_8BIT | RPNG_OUTPUT_HOST_ENDIAN);
+    if ((conversion & RPNG_OUTPUT_8BIT) || !is_little_endian()) conversion &= ~RPNG_OUTPUT_HOST_ENDIAN;
+
+    return conversion;
+}
+
+// Convert one scanline to output format, conversion flags must be provided by rpng_get_row_conversion()
+// NOTE: Most common conversions use specialized kernels (SSE2 if available), other ones are converted pixel by pixel
+static void rpng_convert_row(unsigned char *output, const unsigned char *row, int width, int color_channels, int bit_depth, int conversion)
+{
+    int x = 0;      // First pixel not converted by specialized kernels
+    int count = width*color_channels;
+
+    if ((bit_depth == 16) && (conversion == RPNG_OUTPUT_HOST_ENDIAN))
+    {
+        // Byte swap 16 bit values: big-endian to little-endian
+        int i = 0;
+#if defined(RPNG_SSE2)
+        for (; (i + 8) <= count; i += 8)
+        {
+            __m128i values = _mm_loadu_si128((const __m128i *)(row + i*2));
+            _mm_storeu_si128((__m128i *)(output + i*2), _mm_or_si128(_mm_slli_epi16(values, 8), _mm_srli_epi16(values, 8)));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            output[i*2] = row[i*2 + 1];
+            output[i*2 + 1] = row[i*2];
+        }
+
+        x = width;
+    }
+    else if ((bit_depth == 16) && (conversion == RPNG_OUTPUT_8BIT))
+    {
+        // Reduce 16 bit values to 8 bit, rounded: (value*255 + 32895) >> 16
+        // NOTE: Same result computed in 16 bit: t = value + 128 (saturated), (t - (t >> 8)) >> 8
+        int i = 0;
+#if defined(RPNG_SSE2)
+        const __m128i bias = _mm_set1_epi16(128);
+
+        for (; (i + 16) <= count; i += 16)
+        {
+            __m128i values0 = _mm_loadu_si128((const __m128i *)(row + i*2));
+            __m128i values1 = _mm_loadu_si128((const __m128i *)(row + i*2 + 16));
+            values0 = _mm_adds_epu16(_mm_or_si128(_mm_slli_epi16(values0, 8), _mm_srli_epi16(values0, 8)), bias);
+            values1 = _mm_adds_epu16(_mm_or_si128(_mm_slli_epi16(values1, 8), _mm_srli_epi16(values1, 8)), bias);
+            values0 = _mm_srli_epi16(_mm_sub_epi16(values0, _mm_srli_epi16(values0, 8)), 8);
+            values1 = _mm_srli_epi16(_mm_sub_epi16(values1, _mm_srli_epi16(values1, 8)), 8);
+            _mm_storeu_si128((__m128i *)(output + i), _mm_packus_epi16(values0, values1));
+        }
+#endif
+        for (; i < count; i++) output[i] = (unsigned char)((((row[i*2] << 8) | row[i*2 + 1])*255u + 32895u) >> 16);
+
+        x = width;
+    }
+    else if ((bit_depth == 8) && (color_channels == 4))
     {
-        if (forced_filter_type == -1)
+        // RGBA: swizzle to BGRA and/or premultiply alpha, rounded: (color*alpha + 127)/255
+        // NOTE: Same result computed in 16 bit: t = color*alpha + 128, (t + (t >> 8)) >> 8
+#if defined(RPNG_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(128);
+        const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+        const __m128i alpha_max = _mm_set1_epi16(255);
+        bool premultiply = (conversion & RPNG_OUTPUT_PREMULTIPLY) != 0;
+        bool swizzle = (conversion & RPNG_OUTPUT_BGRA) != 0;
+
+        for (; (x + 4) <= width; x += 4)
         {
-            // Choose the best filter type for every scanline
-            // REF: https://www.w3.org/TR/PNG-Encoders.html#E.Filter-selection
-            for (int p = 0; p < scanline_size; p++)
+            __m128i pixels = _mm_loadu_si128((const __m128i *)(row + x*4));
+            __m128i halves[2] = { _mm_unpacklo_epi8(pixels, zero), _mm_unpackhi_epi8(pixels, zero) };   // 2 pixels per half, 16 bit channels
+
+            for (int h = 0; h < 2; h++)
             {
-                // x = current byte
-                // a = left pixel byte (from current)
-                // b = above pixel byte (from current)
-                // c = left pixel byte (from b)
-                x = (int)((unsigned char *)image_data)[scanline_size*y + p];
-                a = (p >= pixel_size) ? (int)((unsigned char *)image_data)[scanline_size*y + p - pixel_size] : 0;
-                b = (y > 0) ? (int)((unsigned char *)image_data)[scanline_size*(y - 1) + p] : 0;
-                c = (y > 0) ? ((p >= pixel_size) ? (int)((unsigned char *)image_data)[scanline_size*(y - 1) + p - pixel_size] : 0) : 0;
-
-                // Heuristic: Compute the output scanline using all five filters
-                // REF: https://www.w3.org/TR/PNG/#9Filters
-                for (int filter = 0; filter < 5; filter++)
+                if (premultiply)
                 {
-                    switch (filter)
-                    {
-                        case 0: out = x; break;
-                        case 1: out = x - a; break;
-                        case 2: out = x - b; break;
-                        case 3: out = x - ((a + b)>>1); break;
-                        case 4: out = x - rpng_paeth_predictor(a, b, c); break;
-                        default: break;
-                    }
-
-                    sum_value[filter] += abs((signed char)out);
+                    // Alpha broadcasted to all pixel channels, alpha channel multiplied by 255 to be kept
+                    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                    alpha = _mm_or_si128(_mm_andnot_si128(alpha_lanes, alpha), _mm_and_si128(alpha_lanes, alpha_max));
+                    __m128i t = _mm_add_epi16(_mm_mullo_epi16(halves[h], alpha), bias);
+                    halves[h] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
                 }
+
+                if (swizzle) halves[h] = _mm_shufflehi_epi16(_mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
             }
 
-            // Select the filter that gives the smallest sum of absolute values of outputs.
-            // NOTE: Considering the output bytes as signed differences for the test.
-            best_filter = 0;
-            int best_value = sum_value[0];
+            _mm_storeu_si128((__m128i *)(output + x*4), _mm_packus_epi16(halves[0], halves[1]));
+        }
+#endif
+    }
+    else if ((bit_depth == 8) && !(conversion & RPNG_OUTPUT_PREMULTIPLY))
+    {
+        // Gray, gray+alpha or RGB expanded to RGBA/BGRA
+        // NOTE: Pixel sizes are constant per case, so loops are unrolled/vectorized by compiler
+        int r = (conversion & RPNG_OUTPUT_BGRA)? 2 : 0;
+        int b = 2 - r;
 
-            for (int filter = 1; filter < 5; filter++)
+        switch (color_channels)
+        {
+            case 1: for (int i = 0; i < width; i++) { output[i*4] = output[i*4 + 1] = output[i*4 + 2] = row[i]; output[i*4 + 3] = 255; } break;
+            case 2: for (int i = 0; i < width; i++) { output[i*4] = output[i*4 + 1] = output[i*4 + 2] = row[i*2]; output[i*4 + 3] = row[i*2 + 1]; } break;
+            case 3:
             {
-                if (sum_value[filter] < best_value)
+                for (int i = 0; i < width; i++)
                 {
-                    best_value = sum_value[filter];
-                    best_filter = filter;
+                    output[i*4 + r] = row[i*3];
+                    output[i*4 + 1] = row[i*3 + 1];
+                    output[i*4 + b] = row[i*3 + 2];
+                    output[i*4 + 3] = 255;
                 }
-            }
+            } break;
+            default: break;
         }
-        else if ((forced_filter_type >= 0) && (forced_filter_type <= 4)) best_filter = forced_filter_type;
 
-        // Register scanline filter byte
-        data_filtered[(scanline_size + 1)*y] = best_filter;
+        x = width;
+    }
+
+    if (x < width) rpng_convert_pixels(output, row, x, width, color_channels, bit_depth, conversion);
+}
+
+// Convert scanline pixels to output format one by one, starting at provided pixel (any conversion supported)
+// NOTE: Pixel channels are read as RGBA values (16 bit values in 16 bit range), converted and stored in output order
+static void rpng_convert_pixels(unsigned char *output, const unsigned char *row, int start, int width, int color_channels, int bit_depth, int conversion)
+{
+    static const int output_order[6][4] = { { 0 }, { 0 }, { 0, 3 }, { 0, 1, 2 }, { 0, 1, 2, 3 }, { 2, 1, 0, 3 } };
+
+    bool wide = (bit_depth == 16);
+    bool alpha = (color_channels == 2) || (color_channels == 4);
+    unsigned int max = wide? 65535 : 255;
+    int output_channels = (conversion & (RPNG_OUTPUT_RGBA | RPNG_OUTPUT_BGRA))? 4 : color_channels;
+    int output_wide = (wide && !(conversion & RPNG_OUTPUT_8BIT));
+    const int *order = output_order[(conversion & RPNG_OUTPUT_BGRA)? 5 : output_channels];
+
+    for (int x = start; x < width; x++)
+    {
+        const unsigned char *pixel = row + (size_t)x*color_channels*(wide? 2 : 1);
+        unsigned char *result = output + (size_t)x*output_channels*(output_wide? 2 : 1);
+        unsigned int value[4] = { 0, 0, 0, max };
+
+        for (int c = 0; c < color_channels; c++) value[c] = wide? ((pixel[c*2] << 8) | pixel[c*2 + 1]) : pixel[c];
 
-        // Apply the best_filter to scanline
-        for (int p = 0; p < scanline_size; p++)
+        if (color_channels <= 2)
         {
-            x = (int)((unsigned char *)image_data)[scanline_size*y + p];
-            a = (p >= pixel_size)? (int)((unsigned char *)image_data)[scanline_size*y + p - pixel_size] : 0;
-            b = (y > 0)? (int)((unsigned char *)image_data)[scanline_size*(y - 1) + p] : 0;
-            c = (y > 0)? ((p >= pixel_size) ? (int)((unsigned char *)image_data)[scanline_size*(y - 1) + p - pixel_size] : 0) : 0;
+            if (alpha) value[3] = value[1];
+            value[1] = value[2] = value[0];
+        }
 
-            switch (best_filter)
+        if (conversion & RPNG_OUTPUT_PREMULTIPLY)
+        {
+            for (int c = 0; c < 3; c++)
             {
-                case 0: out = x; break;
-                case 1: out = x - a; break;
-                case 2: out = x - b; break;
-                case 3: out = x - ((a + b)>>1); break;
-                case 4: out = x - rpng_paeth_predictor(a, b, c); break;
-                default: break;
+                unsigned int t = value[c]*value[3] + (max + 1)/2;
+                value[c] = wide? ((t + (t >> 16)) >> 16) : ((t + (t >> 8)) >> 8);
             }
+        }
+
+        if (wide && !output_wide) for (int c = 0; c < 4; c++) value[c] = (value[c]*255u + 32895u) >> 16;
 
-            // Register scanline filtered values, byte by byte
-            data_filtered[(scanline_size + 1)*y + 1 + p] = (unsigned char)out;
+        for (int c = 0; c < output_channels; c++)
+        {
+            unsigned int v = value[order[c]];
+
+            if (!output_wide) result[c] = (unsigned char)v;
+            else if (conversion & RPNG_OUTPUT_HOST_ENDIAN)
+            {
+                result[c*2] = (unsigned char)(v & 0xff);
+                result[c*2 + 1] = (unsigned char)(v >> 8);
+            }
+            else
+            {
+                result[c*2] = (unsigned char)(v >> 8);
+                result[c*2 + 1] = (unsigned char)(v & 0xff);
+            }
         }
     }
+}
 
-    // Compress filtered image data and generate a valid zlib stream
-    struct sdefl *sde = (struct sdefl*)RPNG_CALLOC(sizeof(struct sdefl), 1);
-    int bounds = sdefl_bound(data_filtered_size);
-    char *comp_data = (char *)RPNG_CALLOC(bounds, 1);
-    int comp_data_size = zsdeflate(sde, comp_data, data_filtered, data_filtered_size, RPNG_COMPRESSION_LEVEL);
-    RPNG_FREE(data_filtered);
-    RPNG_FREE(sde);
+// Get palette colors lookup table: 256 colors packed as 32 bit values, bytes stored in output order (RGBA/BGRA)
+// NOTE: Colors are premultiplied if required, indexes out of palette range are expanded as opaque black
+static void rpng_get_palette_lut(unsigned int *lut, const rpng_color *colors, int color_count, int output_format)
+{
+    int r = (output_format & RPNG_OUTPUT_BGRA)? 2 : 0;
+    int b = 2 - r;
 
-    if ((comp_data != NULL) && (comp_data_size > 0))
+    for (int i = 0; i < 256; i++)
     {
-        idat_data = comp_data;
-        *output_size = comp_data_size;
-        RPNG_LOG("INFO: Image data deflated successfully: %i bytes -> %i bytes\n", data_filtered_size, comp_data_size);
-    }
-    else RPNG_LOG("INFO: Image data deflating failed\n");
+        rpng_color color = { 0, 0, 0, 255 };
+        if (i < color_count) color = colors[i];
+        unsigned char *entry = (unsigned char *)&lut[i];
 
-    return idat_data;
+        if (output_format & RPNG_OUTPUT_PREMULTIPLY)
+        {
+            unsigned int t = 0;
+            t = color.r*color.a + 128; color.r = (unsigned char)((t + (t >> 8)) >> 8);
+            t = color.g*color.a + 128; color.g = (unsigned char)((t + (t >> 8)) >> 8);
+            t = color.b*color.a + 128; color.b = (unsigned char)((t + (t >> 8)) >> 8);
+        }
+
+        entry[r] = color.r;
+        entry[1] = color.g;
+        entry[b] = color.b;
+        entry[3] = color.a;
+    }
 }
 
-// Decompress and unfilter image data (IDAT)
-static char *rpng_inflate_image_data(char *image_data, int image_data_size, int width, int height, int pixel_size)
+// Read palette colors lookup table from memory buffer: PLTE colors and tRNS alpha (if provided)
+// NOTE: Chunks data is read in place, returns false if no valid palette is found
+static bool rpng_read_palette_lut(const char *buffer, int output_format, unsigned int *lut)
 {
-    char *image_data_unfiltered = NULL;
-    char *image_data_filtered = (char *)RPNG_CALLOC(RPNG_MAX_OUTPUT_SIZE, 1); // WARNING: Allocate enough memory to load full image decompressed
+    rpng_color colors[256] = { 0 };
+    const unsigned char *chunk_palette = (const unsigned char *)rpng_find_chunk(buffer, "PLTE");
+    if (chunk_palette == NULL) return false;
 
-    // Decompress IDAT chunk data
-    int image_data_decomp_size = zsinflate(image_data_filtered, RPNG_MAX_OUTPUT_SIZE, image_data, image_data_size);
+    int color_count = swap_endian(((const unsigned int *)chunk_palette)[0])/3;
+    if ((color_count <= 0) || (color_count > 256)) return false;
 
-    RPNG_LOG("INFO: IDAT data decompressed: %i -> %i\n", image_data_size, image_data_decomp_size);
-
-    if ((image_data_filtered != NULL) && (image_data_decomp_size > 0))
+    for (int i = 0; i < color_count; i++)
     {
-        // Now we have the data decompressed but every scanline of the image was originally filtered for
-        // maximum compression and one extra byte with the filter type was added to every scanline
-        // We must undo that image prefiltering for every scanline
+        colors[i].r = chunk_palette[8 + i*3 + 0];
+        colors[i].g = chunk_palette[8 + i*3 + 1];
+        colors[i].b = chunk_palette[8 + i*3 + 2];
+        colors[i].a = 255;
+    }
 
-        // Image data reverse pre-processing for filter type
-        //int pixel_size = *color_channels*(*bit_depth/8);
-        int scanline_size = width*pixel_size;
-        image_data_unfiltered = (char *)RPNG_CALLOC(image_data_decomp_size, 1);  // Actually data unfiltered size should be smaller
+    // NOTE: Palette alpha could contain less entries than palette, remaining ones are opaque
+    const unsigned char *chunk_alpha = (const unsigned char *)rpng_find_chunk(buffer, "tRNS");
 
-        int current_filter = 0;
-        int out = 0, x = 0, a = 0, b = 0, c = 0;
+    if (chunk_alpha != NULL)
+    {
+        int alpha_count = swap_endian(((const unsigned int *)chunk_alpha)[0]);
+        for (int i = 0; (i < alpha_count) && (i < color_count); i++) colors[i].a = chunk_alpha[8 + i];
+    }
 
-        // Reverse scanlines filters
-        for (int y = 0; y < height; y++)   // Move scanline by scanline, we must discard first byte = current_filter
-        {
-            current_filter = (int)image_data_filtered[(1 + scanline_size)*y];
+    rpng_get_palette_lut(lut, colors, color_count, output_format);
 
-            for (int p = 0; p < scanline_size; p++)
-            {
-                // x = current byte
-                // a = left pixel byte (from current)
-                // b = above pixel byte (from current)
-                // c = left pixel byte (from b)
-                x = (int)(image_data_filtered[(1 + scanline_size)*y + 1 + p]);
-                a = (p >= pixel_size) ? (int)(image_data_unfiltered[scanline_size*y + p - pixel_size]) : 0;
-                b = (y > 0) ? (int)(image_data_unfiltered[scanline_size*(y - 1) + p]) : 0;
-                c = (y > 0) ? ((p >= pixel_size) ? (int)(image_data_unfiltered[scanline_size*(y - 1) + p - pixel_size]) : 0) : 0;
-
-                switch (current_filter)
-                {
-                    case 0: out = x; break;         // Filter type 0: None (Usually used for indexed images)
-                    case 1: out = x + a; break;     // Filter type 1: Sub
-                    case 2: out = x + b; break;     // Filter type 2: Up
-                    case 3: out = x + ((a + b)>>1); break;    // Filter type 3: Average
-                    case 4: out = x + rpng_paeth_predictor(a, b, c); break;  // Filter type 4: Paeth
-                    default: break;
-                }
+    return true;
+}
 
-                // Register scanline unfiltered values, byte by byte
-                image_data_unfiltered[y*scanline_size + p] = (char)out;
-            }
-        }
+// Expand one scanline of palette indexes to 32 bit colors using palette colors lookup table
+// NOTE: AVX2 gathers 8 colors per instruction, portable code copies every color as a 32 bit value
+static void rpng_expand_row(unsigned char *output, const unsigned char *row, int width, const unsigned int *lut)
+{
+    int x = 0;
 
-        RPNG_FREE(image_data_filtered);
+#if defined(RPNG_AVX2)
+    for (; (x + 8) <= width; x += 8)
+    {
+        __m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(row + x)));
+        _mm256_storeu_si256((__m256i *)(output + x*4), _mm256_i32gather_epi32((const int *)lut, indexes, 4));
     }
+#endif
 
-    return image_data_unfiltered;
+    for (; x < width; x++) memcpy(output + x*4, &lut[row[x]], 4);
 }
 
 // Swap integer from big<->little endian
@@ -2193,8 +5020,23 @@ static unsigned int swap_endian(unsigned int value)
     return res;
 }
 
+// Check if host byte order is little-endian
+static bool is_little_endian(void)
+{
+    const unsigned short value = 1;
+
+    return (*(const unsigned char *)&value == 1);
+}
+
 // Compute CRC32
 static unsigned int compute_crc32(unsigned char *buffer, int size)
+{
+    return update_crc32(0, buffer, size);
+}
+
+// Update CRC32 with new data, it allows computing CRC incrementally
+// NOTE: Initial crc value must be 0, returned value is the CRC32 of all data provided until the moment
+static unsigned int update_crc32(unsigned int crc, const unsigned char *buffer, int size)
 {
     static unsigned int crc_table[256] = {
         0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
@@ -2231,7 +5073,7 @@ static unsigned int compute_crc32(unsigned char *buffer, int size)
         0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
     };
 
-    unsigned int crc = ~0u;
+    crc = ~crc;
 
     for (int i = 0; i < size; i++) crc = (crc >> 8) ^ crc_table[buffer[i] ^ (crc & 0xff)];
 
@@ -2239,7 +5081,7 @@ static unsigned int compute_crc32(unsigned char *buffer, int size)
 }
 
 // Load data from file into a buffer
-static char *load_file_to_buffer(const char *filename, int *bytes_read)
+static char *load_file_to_buffer(const char *filename, size_t *bytes_read)
 {
     char *data = NULL;
     *bytes_read = 0;
@@ -2254,20 +5096,31 @@ static char *load_file_to_buffer(const char *filename, int *bytes_read)
         {
             // WARNING: On binary streams SEEK_END could not be found,
             // using fseek() and ftell() could not work in some (rare) cases
+            // NOTE: On Windows long type is 32bit, 64bit functions are required for files bigger than 2GB
+        #if defined(_WIN32)
+            _fseeki64(file, 0, SEEK_END);
+            long long file_size = _ftelli64(file);
+            _fseeki64(file, 0, SEEK_SET);
+        #else
             fseek(file, 0, SEEK_END);
-            int file_size = ftell(file);
+            long long file_size = ftell(file);
             fseek(file, 0, SEEK_SET);
+        #endif
 
-            if (file_size > 0)
+            if ((file_size > 0) && ((unsigned long long)file_size <= (size_t)-1))
             {
-                data = (char *)RPNG_MALLOC(sizeof(unsigned char)*file_size);
+                data = (char *)RPNG_MALLOC((size_t)file_size);
 
-                // NOTE: fread() returns number of read elements instead of bytes, so we read [1 byte, file_size elements]
-                int count = (int)fread(data, sizeof(char), file_size, file);
-                *bytes_read = count;
+                if (data != NULL)
+                {
+                    // NOTE: fread() returns number of read elements instead of bytes, so we read [1 byte, file_size elements]
+                    size_t count = fread(data, sizeof(char), (size_t)file_size, file);
+                    *bytes_read = count;
 
-                if (count != file_size) RPNG_LOG("FILEIO: [%s] File partially loaded\n", filename);
-                else RPNG_LOG("FILEIO: [%s] File loaded successfully\n", filename);
+                    if (count != (size_t)file_size) RPNG_LOG("FILEIO: [%s] File partially loaded\n", filename);
+                    else RPNG_LOG("FILEIO: [%s] File loaded successfully\n", filename);
+                }
+                else RPNG_LOG("FILEIO: [%s] Failed to allocate memory for file\n", filename);
             }
             else RPNG_LOG("FILEIO: [%s] Failed to read file\n", filename);
 
@@ -2286,7 +5139,7 @@ static char *load_file_to_buffer(const char *filename, int *bytes_read)
 }
 
 // Write data to file from buffer
-static int save_file_from_buffer(const char *filename, void *data, int bytesToWrite)
+static int save_file_from_buffer(const char *filename, void *data, size_t bytesToWrite)
 {
     int result = RPNG_SUCCESS;
 #if !defined(RPNG_NO_STDIO)
@@ -2296,13 +5149,96 @@ static int save_file_from_buffer(const char *filename, void *data, int bytesToWr
 
         if (file != NULL)
         {
-            int count = (int)fwrite(data, sizeof(char), bytesToWrite, file);
+            size_t count = fwrite(data, sizeof(char), bytesToWrite, file);
+
+            if (count == 0) RPNG_LOG("FILEIO: [%s] Failed to write file\n", filename);
+            else if (count != bytesToWrite) RPNG_LOG("FILEIO: [%s] File partially written\n", filename);
+            else RPNG_LOG("FILEIO: [%s] File saved successfully\n", filename);
+
+            fclose(file);
+        }
+        else
+        {
+            result = RPNG_ERROR_FILE_OPEN;
+            RPNG_LOG("FILEIO: [%s] Failed to open file\n", filename);
+        }
+    }
+    else RPNG_LOG("FILEIO: File path or data provided are not valid\n");
+#else
+    (void)filename;
+    (void)data;
+    (void)bytesToWrite;
+    #ifndef RPNG_NO_STDIO_WARNING
+        #warning No FILE I/O API, RPNG_NO_STDIO defined
+    #endif
+#endif
+    return result;
+}
+
+// Write data to file from multiple pieces, written in order without joining them (scatter-gather)
+// NOTE: POSIX systems write all pieces with a single writev() call (if not partially written)
+static int save_file_from_pieces(const char *filename, const rpng_data_piece *pieces, int count)
+{
+    int result = RPNG_SUCCESS;
+#if !defined(RPNG_NO_STDIO)
+    size_t bytesToWrite = 0;
+    for (int i = 0; i < count; i++) bytesToWrite += pieces[i].size;
+
+    if ((filename != NULL) && (count > 0) && (count <= RPNG_MAX_DATA_PIECES) && (bytesToWrite > 0))
+    {
+        size_t bytesWritten = 0;
+        bool opened = false;
+    #if defined(_WIN32)
+        FILE *file = fopen(filename, "wb");
+
+        if (file != NULL)
+        {
+            opened = true;
+            for (int i = 0; i < count; i++) bytesWritten += fwrite(pieces[i].data, sizeof(char), pieces[i].size, file);
+            fclose(file);
+        }
+    #else
+        int file = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (file != -1)
+        {
+            opened = true;
+            struct iovec iov[RPNG_MAX_DATA_PIECES] = { 0 };
+            for (int i = 0; i < count; i++)
+            {
+                iov[i].iov_base = (void *)pieces[i].data;
+                iov[i].iov_len = pieces[i].size;
+            }
+
+            // Pieces could be partially written, writing continues from first piece not fully written
+            int first = 0;
+            while (first < count)
+            {
+                ssize_t written = writev(file, iov + first, count - first);
+                if (written <= 0) break;
+
+                bytesWritten += (size_t)written;
+                while ((first < count) && ((size_t)written >= iov[first].iov_len))
+                {
+                    written -= (ssize_t)iov[first].iov_len;
+                    first++;
+                }
+
+                if (first < count)
+                {
+                    iov[first].iov_base = (char *)iov[first].iov_base + written;
+                    iov[first].iov_len -= (size_t)written;
+                }
+            }
 
-            if (count == 0) RPNG_LOG("FILEIO: [%s] Failed to write file\n", filename);
-            else if (count != bytesToWrite) RPNG_LOG("FILEIO: [%s] File partially written\n", filename);
+            close(file);
+        }
+    #endif
+        if (opened)
+        {
+            if (bytesWritten == 0) RPNG_LOG("FILEIO: [%s] Failed to write file\n", filename);
+            else if (bytesWritten != bytesToWrite) RPNG_LOG("FILEIO: [%s] File partially written\n", filename);
             else RPNG_LOG("FILEIO: [%s] File saved successfully\n", filename);
-
-            fclose(file);
         }
         else
         {
@@ -2313,8 +5249,8 @@ static int save_file_from_buffer(const char *filename, void *data, int bytesToWr
     else RPNG_LOG("FILEIO: File path or data provided are not valid\n");
 #else
     (void)filename;
-    (void)data;
-    (void)bytesToWrite;
+    (void)pieces;
+    (void)count;
     #ifndef RPNG_NO_STDIO_WARNING
         #warning No FILE I/O API, RPNG_NO_STDIO defined
     #endif
@@ -2348,6 +5284,12 @@ static bool file_exists(const char *filename)
 #include <string.h> /* memcpy */
 #include <limits.h> /* CHAR_BIT */
 
+#ifndef SDEFL_MALLOC
+#include <stdlib.h> /* malloc, free */
+#define SDEFL_MALLOC(sz) malloc(sz)
+#define SDEFL_FREE(p) free(p)
+#endif
+
 #define SDEFL_NIL               (-1)
 #define SDEFL_MAX_MATCH         258
 #define SDEFL_MAX_CODE_LEN      (15)
@@ -2359,6 +5301,13 @@ static bool file_exists(const char *filename)
 #define SDEFL_PRE_CODES         (7)
 #define SDEFL_CNT_NUM(n)        ((((n)+3u/4u)+3u)&~3u)
 #define SDEFL_EOB               (256)
+#define SDEFL_OPT_MATCHES       (8)
+#define SDEFL_OPT_CACHE         (4)
+#define SDEFL_OPT_ITER          (4)
+#define SDEFL_OPT_NICE          SDEFL_MAX_MATCH
+#define SDEFL_OPT_CHAIN         (1 << 12)
+#define SDEFL_PROBE_LEN         (4*1024)
+#define SDEFL_PROBE_SKIP        (32*1024)
 
 #define sdefl_npow2(n) (1 << (sdefl_ilog2((n)-1) + 1))
 #define sdefl_div_round_up(n,d) (((n)+((d)-1))/(d))
@@ -2394,21 +5343,72 @@ sdefl_uload32(const void *p) {
   return n;
 }
 static unsigned
-sdefl_hash32(const void *p) {
+sdefl_hash32(const void *p, int hash_bits) {
   unsigned n = sdefl_uload32(p);
-  return (n * 0x9E377989) >> (32 - SDEFL_HASH_BITS);
+  return (n * 0x9E377989) >> (32 - hash_bits);
+}
+static int
+sdefl_ctz64(unsigned long long n) {
+  /* n must be non-zero */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long lsbp = 0;
+  _BitScanForward64(&lsbp, n);
+  return (int)lsbp;
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(n);
+#else
+  int i = 0;
+  while (!(n & 0xFF)) n >>= 8, i += 8;
+  return i;
+#endif
+}
+static int
+sdefl_cmp(const unsigned char *a, const unsigned char *b, int n, int max_match) {
+  /* extend match from n bytes, 8 bytes at a time while the whole word fits */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || \
+    defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+  while (n + 8 <= max_match) {
+    unsigned long long x, y;
+    memcpy(&x, a + n, sizeof(x));
+    memcpy(&y, b + n, sizeof(y));
+    if (x != y) {
+      /* first differing byte is the lowest one on little-endian hosts */
+      return n + (sdefl_ctz64(x ^ y) >> 3);
+    }
+    n += 8;
+  }
+#endif
+  while (n < max_match && a[n] == b[n]) n++;
+  return n;
 }
 static void
-sdefl_put(unsigned char **dst, struct sdefl *s, int code, int bitcnt) {
-  s->bits |= (code << s->bitcnt);
+sdefl_put(unsigned char **dst, struct sdefl *s, unsigned code, int bitcnt) {
+  /* bits are accumulated into a 64-bit buffer and written by 32-bit words,
+   * at most 32 bits can be added, less than 32 bits are kept pending */
+  s->bits |= (unsigned long long)code << s->bitcnt;
   s->bitcnt += bitcnt;
-  while (s->bitcnt >= 8) {
+  if (s->bitcnt >= 32) {
     unsigned char *tar = *dst;
-    *tar = (unsigned char)(s->bits & 0xFF);
+    tar[0] = (unsigned char)(s->bits & 0xFF);
+    tar[1] = (unsigned char)((s->bits >> 8) & 0xFF);
+    tar[2] = (unsigned char)((s->bits >> 16) & 0xFF);
+    tar[3] = (unsigned char)((s->bits >> 24) & 0xFF);
+    s->bits >>= 32;
+    s->bitcnt -= 32;
+    *dst = tar + 4;
+  }
+}
+static void
+sdefl_put_align(unsigned char **dst, struct sdefl *s) {
+  /* pad pending bits to byte boundary and write them */
+  unsigned char *tar = *dst;
+  while (s->bitcnt > 0) {
+    *tar++ = (unsigned char)(s->bits & 0xFF);
     s->bits >>= 8;
     s->bitcnt -= 8;
-    *dst = *dst + 1;
   }
+  s->bits = 0, s->bitcnt = 0;
+  *dst = tar;
 }
 static void
 sdefl_heap_sub(unsigned A[], unsigned len, unsigned sub) {
@@ -2643,8 +5643,28 @@ sdefl_match_codes(struct sdefl_match_codest *cod, int dist, int len) {
 }
 enum sdefl_blk_type {
   SDEFL_BLK_UCOMPR,
+  SDEFL_BLK_FIXED,
   SDEFL_BLK_DYN
 };
+static int
+sdefl_fixed_lit_len(int sym) {
+  return (sym < 144) ? 8 : (sym < 256) ? 9 : (sym < 280) ? 7 : 8;
+}
+static void
+sdefl_fixed_codes(struct sdefl_codes *cod) {
+  /* canonical codes for fixed huffman lengths (RFC 1951, 3.2.6) */
+  unsigned nxt[10] = {0};
+  int sym;
+  for (sym = 0; sym < SDEFL_SYM_MAX; ++sym)
+    cod->len.lit[sym] = (unsigned char)sdefl_fixed_lit_len(sym);
+  nxt[7] = 0, nxt[8] = (nxt[7] + 24) << 1, nxt[9] = (nxt[8] + 152) << 1;
+  for (sym = 0; sym < SDEFL_SYM_MAX; ++sym)
+    cod->word.lit[sym] = sdefl_rev(nxt[cod->len.lit[sym]]++, cod->len.lit[sym]);
+  for (sym = 0; sym < SDEFL_OFF_MAX; ++sym) {
+    cod->len.off[sym] = 5;
+    cod->word.off[sym] = sdefl_rev((unsigned)sym, 5);
+  }
+}
 static enum sdefl_blk_type
 sdefl_blk_type(const struct sdefl *s, int blk_len, int pre_item_len,
                const unsigned *pre_freq, const unsigned char *pre_len) {
@@ -2654,23 +5674,32 @@ sdefl_blk_type(const struct sdefl *s, int blk_len, int pre_item_len,
   static const unsigned char x_off_bits[] = {0,0,0,0,1,1,2,2, 3,3,4,4,5,5,6,6,
     7,7,8,8,9,9,10,10, 11,11,12,12,13,13};
 
-  int dyn_cost = 0;
-  int fix_cost = 0;
+  unsigned dyn_cost = 0;
+  unsigned fix_cost = 0;
+  unsigned raw_cost = 0;
   int sym = 0;
 
-  dyn_cost += 5 + 5 + 4 + (3 * pre_item_len);
+  /* exact block sizes in bits: dynamic huffman (tables header included),
+   * fixed huffman and stored (split into 64KB blocks, byte aligned) */
+  dyn_cost += 3 + 5 + 5 + 4 + (3 * pre_item_len);
   for (sym = 0; sym < SDEFL_PRE_MAX; sym++)
     dyn_cost += pre_freq[sym] * (x_pre_bits[sym] + pre_len[sym]);
-  for (sym = 0; sym < 256; sym++)
+  fix_cost += 3;
+  for (sym = 0; sym <= SDEFL_EOB; sym++) {
     dyn_cost += s->freq.lit[sym] * s->cod.len.lit[sym];
-  dyn_cost += s->cod.len.lit[SDEFL_EOB];
-  for (sym = 257; sym < 286; sym++)
+    fix_cost += s->freq.lit[sym] * (unsigned)sdefl_fixed_lit_len(sym);
+  }
+  for (sym = 257; sym < 286; sym++) {
     dyn_cost += s->freq.lit[sym] * (x_len_bits[sym - 257] + s->cod.len.lit[sym]);
-  for (sym = 0; sym < 30; sym++)
+    fix_cost += s->freq.lit[sym] * (x_len_bits[sym - 257] + (unsigned)sdefl_fixed_lit_len(sym));
+  }
+  for (sym = 0; sym < 30; sym++) {
     dyn_cost += s->freq.off[sym] * (x_off_bits[sym] + s->cod.len.off[sym]);
-
-  fix_cost += 8*(5 * sdefl_div_round_up(blk_len, SDEFL_RAW_BLK_SIZE) + blk_len + 1 + 2);
-  return (dyn_cost < fix_cost) ? SDEFL_BLK_DYN : SDEFL_BLK_UCOMPR;
+    fix_cost += s->freq.off[sym] * (x_off_bits[sym] + 5u);
+  }
+  raw_cost += 8*(5 * (unsigned)sdefl_div_round_up(blk_len, SDEFL_RAW_BLK_SIZE) + (unsigned)blk_len + 1 + 2);
+  if (dyn_cost < fix_cost && dyn_cost < raw_cost) return SDEFL_BLK_DYN;
+  return (fix_cost < raw_cost) ? SDEFL_BLK_FIXED : SDEFL_BLK_UCOMPR;
 }
 static void
 sdefl_put16(unsigned char **dst, unsigned short x) {
@@ -2689,16 +5718,43 @@ sdefl_match(unsigned char **dst, struct sdefl *s, int dist, int len) {
 
   struct sdefl_match_codest cod;
   sdefl_match_codes(&cod, dist, len);
-  sdefl_put(dst, s, (int)s->cod.word.lit[cod.lc], s->cod.len.lit[cod.lc]);
-  sdefl_put(dst, s, len - lmin[cod.ls], lxn[cod.ls]);
-  sdefl_put(dst, s, (int)s->cod.word.off[cod.dc], s->cod.len.off[cod.dc]);
-  sdefl_put(dst, s, dist - dmin[cod.dc], cod.dx);
+  sdefl_put(dst, s, s->cod.word.lit[cod.lc] | ((unsigned)(len - lmin[cod.ls]) << s->cod.len.lit[cod.lc]),
+            s->cod.len.lit[cod.lc] + lxn[cod.ls]);
+  sdefl_put(dst, s, s->cod.word.off[cod.dc] | ((unsigned)(dist - dmin[cod.dc]) << s->cod.len.off[cod.dc]),
+            s->cod.len.off[cod.dc] + cod.dx);
+}
+static void
+sdefl_put_lits(unsigned char **dst, struct sdefl *s, const unsigned char *lits, int n) {
+  /* literal codes are at most 14 bits, two literals are written per put */
+  const unsigned *word = s->cod.word.lit;
+  const unsigned char *len = s->cod.len.lit;
+  int i = 0;
+  for (; i + 1 < n; i += 2) {
+    unsigned c0 = lits[i], c1 = lits[i + 1];
+    sdefl_put(dst, s, word[c0] | (word[c1] << len[c0]), len[c0] + len[c1]);
+  }
+  if (i < n) {
+    sdefl_put(dst, s, word[lits[i]], len[lits[i]]);
+  }
+}
+static void
+sdefl_put_seqs(unsigned char **dst, struct sdefl *s, const unsigned char *in) {
+  /* block sequences and end of block, with current block codes */
+  int i;
+  for (i = 0; i < s->seq_cnt; ++i) {
+    if (s->seq[i].off >= 0) {
+      sdefl_put_lits(dst, s, in + s->seq[i].off, s->seq[i].len);
+    } else {
+      sdefl_match(dst, s, -s->seq[i].off, s->seq[i].len);
+    }
+  }
+  sdefl_put(dst, s, s->cod.word.lit[SDEFL_EOB], s->cod.len.lit[SDEFL_EOB]);
 }
 static void
 sdefl_flush(unsigned char **dst, struct sdefl *s, int is_last,
             const unsigned char *in, int blk_begin, int blk_end) {
   int blk_len = blk_end - blk_begin;
-  int j, i = 0, item_cnt = 0;
+  int i = 0, item_cnt = 0;
   struct sdefl_symcnt symcnt = {0};
   unsigned codes[SDEFL_PRE_MAX];
   unsigned char lens[SDEFL_PRE_MAX];
@@ -2723,15 +5779,13 @@ sdefl_flush(unsigned char **dst, struct sdefl *s, int is_last,
   case SDEFL_BLK_UCOMPR: {
     /* uncompressed blocks */
     int n = sdefl_div_round_up(blk_len, SDEFL_RAW_BLK_SIZE);
+    s->stats.blk_raw++;
     for (i = 0; i < n; ++i) {
       int fin = is_last && (i + 1 == n);
       int amount = blk_len < SDEFL_RAW_BLK_SIZE ? blk_len : SDEFL_RAW_BLK_SIZE;
       sdefl_put(dst, s, !!fin, 1); /* block */
       sdefl_put(dst, s, 0x00, 2); /* stored block */
-      if (s->bitcnt) {
-        sdefl_put(dst, s, 0x00, 8 - s->bitcnt);
-      }
-      assert(s->bitcnt == 0);
+      sdefl_put_align(dst, s);
       sdefl_put16(dst, (unsigned short)amount);
       sdefl_put16(dst, ~(unsigned short)amount);
       memcpy(*dst, in + blk_begin + i * SDEFL_RAW_BLK_SIZE, amount);
@@ -2739,8 +5793,17 @@ sdefl_flush(unsigned char **dst, struct sdefl *s, int is_last,
       blk_len -= amount;
     }
   } break;
+  case SDEFL_BLK_FIXED: {
+    /* fixed huffman block */
+    s->stats.blk_fixed++;
+    sdefl_put(dst, s, !!is_last, 1); /* block */
+    sdefl_put(dst, s, 0x01, 2); /* fixed huffman */
+    sdefl_fixed_codes(&s->cod);
+    sdefl_put_seqs(dst, s, in);
+  } break;
   case SDEFL_BLK_DYN: {
     /* dynamic huffman block */
+    s->stats.blk_dyn++;
     sdefl_put(dst, s, !!is_last, 1); /* block */
     sdefl_put(dst, s, 0x02, 2); /* dynamic huffman */
     sdefl_put(dst, s, symcnt.lit - 257, 5);
@@ -2751,31 +5814,20 @@ sdefl_flush(unsigned char **dst, struct sdefl *s, int is_last,
     }
     for (i = 0; i < symcnt.items; ++i) {
       unsigned sym = items[i] & 0x1F;
-      sdefl_put(dst, s, (int)codes[sym], lens[sym]);
+      sdefl_put(dst, s, codes[sym], lens[sym]);
       if (sym < 16) continue;
       if (sym == 16) sdefl_put(dst, s, items[i] >> 5, 2);
       else if(sym == 17) sdefl_put(dst, s, items[i] >> 5, 3);
       else sdefl_put(dst, s, items[i] >> 5, 7);
     }
-    /* block sequences */
-    for (i = 0; i < s->seq_cnt; ++i) {
-      if (s->seq[i].off >= 0) {
-        for (j = 0; j < s->seq[i].len; ++j) {
-          int c = in[s->seq[i].off + j];
-          sdefl_put(dst, s, (int)s->cod.word.lit[c], s->cod.len.lit[c]);
-        }
-      } else {
-        sdefl_match(dst, s, -s->seq[i].off, s->seq[i].len);
-      }
-    }
-    sdefl_put(dst, s, (int)(s)->cod.word.lit[SDEFL_EOB], (s)->cod.len.lit[SDEFL_EOB]);
+    sdefl_put_seqs(dst, s, in);
   } break;}
   memset(&s->freq, 0, sizeof(s->freq));
   s->seq_cnt = 0;
 }
 static void
 sdefl_seq(struct sdefl *s, int off, int len) {
-  assert(s->seq_cnt + 2 < SDEFL_SEQ_SIZ);
+  assert(s->seq_cnt + 2 < s->seq_siz);
   s->seq[s->seq_cnt].off = off;
   s->seq[s->seq_cnt].len = len;
   s->seq_cnt++;
@@ -2791,6 +5843,40 @@ sdefl_reg_match(struct sdefl *s, int off, int len) {
   s->freq.lit[cod.lc]++;
   s->freq.off[cod.dc]++;
 }
+static void
+sdefl_obs_lit(struct sdefl_split *st, int lit) {
+  st->new_obs[((lit >> 5) & 0x6) | (lit & 1)]++;
+  st->new_obs_cnt++;
+}
+static void
+sdefl_obs_match(struct sdefl_split *st, int len) {
+  st->new_obs[8 + (len >= 9)]++;
+  st->new_obs_cnt++;
+}
+static int
+sdefl_split_chk(struct sdefl_split *st, int blk_len) {
+  /* compare latest symbols distribution against current block one,
+   * block should end if it changed enough to require new huffman tables */
+  int i;
+  if (st->obs_cnt > 0) {
+    unsigned long long delta = 0, cutoff;
+    for (i = 0; i < SDEFL_OBS_NUM; ++i) {
+      unsigned long long expected = (unsigned long long)st->obs[i] * st->new_obs_cnt;
+      unsigned long long actual = (unsigned long long)st->new_obs[i] * st->obs_cnt;
+      delta += (actual > expected) ? actual - expected : expected - actual;
+    }
+    cutoff = (unsigned long long)st->new_obs_cnt * 200 / 512 * st->obs_cnt;
+    if (delta + (unsigned long long)(blk_len / 4096) * st->obs_cnt >= cutoff)
+      return 1;
+  }
+  for (i = 0; i < SDEFL_OBS_NUM; ++i) {
+    st->obs[i] += st->new_obs[i];
+    st->new_obs[i] = 0;
+  }
+  st->obs_cnt += st->new_obs_cnt;
+  st->new_obs_cnt = 0;
+  return 0;
+}
 struct sdefl_match {
   int off;
   int len;
@@ -2798,8 +5884,8 @@ struct sdefl_match {
 static void
 sdefl_fnd(struct sdefl_match *m, const struct sdefl *s, int chain_len,
           int max_match, const unsigned char *in, int p, int e) {
-  int i = s->tbl[sdefl_hash32(in + p)];
-  int limit = ((p - SDEFL_WIN_SIZ) < SDEFL_NIL) ? SDEFL_NIL : (p-SDEFL_WIN_SIZ);
+  int i = s->tbl[sdefl_hash32(in + p, s->hash_bits)];
+  int limit = ((p - s->win_siz) < SDEFL_NIL) ? SDEFL_NIL : (p - s->win_siz);
 
   assert(p < e);
   assert(p + max_match <= e);
@@ -2811,12 +5897,7 @@ sdefl_fnd(struct sdefl_match *m, const struct sdefl *s, int chain_len,
 
     if (in[i + m->len] == in[p + m->len] &&
       (sdefl_uload32(&in[i]) == sdefl_uload32(&in[p]))) {
-      int n = SDEFL_MIN_MATCH;
-      while (n < max_match && in[i + n] == in[p + n]) {
-        assert(i + n < e);
-        assert(p + n < e);
-        n++;
-      }
+      int n = sdefl_cmp(&in[i], &in[p], SDEFL_MIN_MATCH, max_match);
       if (n > m->len) {
         m->len = n, m->off = p - i;
         if (n == max_match)
@@ -2824,79 +5905,432 @@ sdefl_fnd(struct sdefl_match *m, const struct sdefl *s, int chain_len,
       }
     }
     if (!(--chain_len)) break;
-    i = s->prv[i & SDEFL_WIN_MSK];
+    i = s->prv[i & (s->win_siz - 1)];
   }
 }
+static int sdefl_blk(unsigned char **dst, struct sdefl *s, const unsigned char *in,
+                     int i, int blk_end, int in_len, int lvl);
+struct sdefl_opt {
+  unsigned *cost;   /* cost in bits from position to block end */
+  unsigned *path;   /* best choice at position: len << 16 | off, 0 for literal */
+  unsigned *best;   /* cheapest path found, parsed path is not always cheaper */
+  unsigned *mat;    /* matches found at every position: len << 16 | off, increasing lengths */
+  int *mat_at;      /* first match of every position in matches cache */
+  unsigned lit[SDEFL_SYM_MAX];
+  unsigned off[SDEFL_OFF_MAX];
+  unsigned len[SDEFL_MAX_MATCH + 1];
+};
 static int
-sdefl_compr(struct sdefl *s, unsigned char *out, const unsigned char *in,
-            int in_len, int lvl) {
-  unsigned char *q = out;
+sdefl_fnd_all(unsigned *mat, int max_cnt, const struct sdefl *s, int chain_len,
+              int max_match, int nice_match, const unsigned char *in, int p) {
+  /* same search than sdefl_fnd(), every longer match found is recorded (up to
+   * max_cnt), so lengths up to a match length are best served by its offset */
+  int i = s->tbl[sdefl_hash32(in + p, s->hash_bits)];
+  int limit = ((p - s->win_siz) < SDEFL_NIL) ? SDEFL_NIL : (p - s->win_siz);
+  int cnt = 0, best = 0;
+  while (i > limit) {
+    if (in[i + best] == in[p + best] &&
+      (sdefl_uload32(&in[i]) == sdefl_uload32(&in[p]))) {
+      int n = sdefl_cmp(&in[i], &in[p], SDEFL_MIN_MATCH, max_match);
+      if (n > best) {
+        /* cache is full: longest match replaces last one */
+        cnt -= (cnt == max_cnt);
+        mat[cnt++] = ((unsigned)n << 16) | (unsigned)(p - i);
+        best = n;
+        if (n >= nice_match)
+          break;
+      }
+    }
+    if (!(--chain_len)) break;
+    i = s->prv[i & (s->win_siz - 1)];
+  }
+  return cnt;
+}
+static unsigned
+sdefl_opt_costs(struct sdefl_opt *o, const unsigned char *in, int b, int e) {
+  /* symbols costs are the huffman code lengths of current path statistics,
+   * returns current path size in bits (huffman tables not included) */
+  static const unsigned char lxn[] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+  struct sdefl_freq freq = {{0},{0}};
+  unsigned words[SDEFL_SYM_MAX];
+  struct sdefl_lens lens;
+  unsigned bits = 0;
+  int p = b, i;
+  while (p < e) {
+    unsigned choice = o->path[p - b];
+    if (choice) {
+      struct sdefl_match_codest cod;
+      sdefl_match_codes(&cod, (int)(choice & 0xffff), (int)(choice >> 16));
+      freq.lit[cod.lc]++, freq.off[cod.dc]++;
+      bits += lxn[cod.ls] + (unsigned)cod.dx;
+      p += (int)(choice >> 16);
+    } else freq.lit[in[p++]]++;
+  }
+  freq.lit[SDEFL_EOB]++;
+  sdefl_huff(lens.lit, words, freq.lit, SDEFL_SYM_MAX, SDEFL_LIT_LEN_CODES);
+  sdefl_huff(lens.off, words, freq.off, SDEFL_OFF_MAX, SDEFL_OFF_CODES);
+  for (i = 0; i < SDEFL_SYM_MAX; ++i)
+    bits += freq.lit[i] * lens.lit[i];
+  for (i = 0; i < SDEFL_OFF_MAX; ++i)
+    bits += freq.off[i] * lens.off[i];
+  /* unused symbols are expensive, but still reachable */
+  for (i = 0; i < SDEFL_SYM_MAX; ++i)
+    o->lit[i] = lens.lit[i] ? lens.lit[i] : SDEFL_LIT_LEN_CODES;
+  for (i = 0; i < SDEFL_OFF_MAX; ++i)
+    o->off[i] = lens.off[i] ? lens.off[i] : SDEFL_OFF_CODES;
+  for (i = 3; i <= SDEFL_MAX_MATCH; ++i) {
+    struct sdefl_match_codest cod;
+    sdefl_match_codes(&cod, 1, i);
+    o->len[i] = o->lit[cod.lc] + lxn[cod.ls];
+  }
+  return bits;
+}
+static void
+sdefl_opt_parse(struct sdefl_opt *o, const unsigned char *in, int b, int e) {
+  /* minimum cost path from block end, every match length is considered */
+  int p;
+  o->cost[e - b] = 0;
+  for (p = e - 1; p >= b; --p) {
+    int i = p - b, k, n = 3;
+    unsigned best = o->lit[in[p]] + o->cost[i + 1];
+    unsigned choice = 0;
+    for (k = o->mat_at[i]; k < o->mat_at[i + 1]; ++k) {
+      struct sdefl_match_codest cod;
+      int off = (int)(o->mat[k] & 0xffff);
+      int len = (int)(o->mat[k] >> 16);
+      unsigned off_cost;
+      len = (len < e - p) ? len : e - p;
+      sdefl_match_codes(&cod, off, 3);
+      off_cost = o->off[cod.dc] + (unsigned)cod.dx;
+      for (; n <= len; ++n) {
+        unsigned c = off_cost + o->len[n] + o->cost[i + n];
+        if (c < best) {
+          best = c;
+          choice = ((unsigned)n << 16) | (unsigned)off;
+        }
+      }
+    }
+    o->cost[i] = best;
+    o->path[i] = choice;
+  }
+}
+static unsigned
+sdefl_opt_longest(const struct sdefl_opt *o, int i, int left) {
+  /* longest cached match at block position i: len << 16 | off, 0 if none */
+  int k = o->mat_at[i + 1] - 1;
+  unsigned m = (k >= o->mat_at[i]) ? o->mat[k] : 0;
+  unsigned len = m >> 16;
+  len = (len < (unsigned)left) ? len : (unsigned)left;
+  return (len >= SDEFL_MIN_MATCH) ? ((len << 16) | (m & 0xffff)) : 0;
+}
+static int
+sdefl_blk_opt(unsigned char **dst, struct sdefl *s, const unsigned char *in,
+              int i, int blk_end, int in_len) {
+  /* near-optimal parsing: matches of every position are cached, then block is
+   * parsed by minimum cost path, with symbols costs refined on every iteration */
+  struct sdefl_opt *o = 0;
+  int blk_len = blk_end - i, blk_begin = i, e = blk_end, skip = i, obs = i;
+  int p, n = 0, it, litlen = 0, cap;
+  unsigned cost, best;
+
+  cap = blk_len * SDEFL_OPT_CACHE;
+
+  o = (struct sdefl_opt*)SDEFL_MALLOC(sizeof(struct sdefl_opt));
+  if (o) {
+    o->cost = (unsigned*)SDEFL_MALLOC(sizeof(unsigned) * (size_t)(blk_len + 1));
+    o->path = (unsigned*)SDEFL_MALLOC(sizeof(unsigned) * (size_t)(blk_len + 1));
+    o->best = (unsigned*)SDEFL_MALLOC(sizeof(unsigned) * (size_t)(blk_len + 1));
+    o->mat = (unsigned*)SDEFL_MALLOC(sizeof(unsigned) * (size_t)cap);
+    o->mat_at = (int*)SDEFL_MALLOC(sizeof(int) * (size_t)(blk_len + 1));
+  }
+  if (!o || !o->cost || !o->path || !o->best || !o->mat || !o->mat_at) {
+    if (o) {
+      SDEFL_FREE(o->cost); SDEFL_FREE(o->path); SDEFL_FREE(o->best);
+      SDEFL_FREE(o->mat); SDEFL_FREE(o->mat_at);
+      SDEFL_FREE(o);
+    }
+    return sdefl_blk(dst, s, in, i, blk_end, in_len, SDEFL_LVL_OPT - 1);
+  }
+  /* find and cache matches, block can end earlier if symbols statistics
+   * change (observed as greedy parsing), cache room is kept for one match at
+   * every remaining position, so block never ends on a full cache */
+  memset(&s->split, 0, sizeof(s->split));
+  for (p = blk_begin; p < e; ++p) {
+    int left = e - p, best_len = 0;
+    int max_match = (left > SDEFL_MAX_MATCH) ? SDEFL_MAX_MATCH : left;
+    int nice_match = (SDEFL_OPT_NICE < max_match) ? SDEFL_OPT_NICE : max_match;
+    int room = cap - n - (left - 1);
+    o->mat_at[p - blk_begin] = n;
+    if (p >= skip && max_match > SDEFL_MIN_MATCH) {
+      int max_cnt = (room < SDEFL_OPT_MATCHES) ? room : SDEFL_OPT_MATCHES;
+      int cnt = sdefl_fnd_all(o->mat + n, max_cnt, s, SDEFL_OPT_CHAIN, max_match, nice_match, in, p);
+      if (cnt) {
+        best_len = (int)(o->mat[n + cnt - 1] >> 16);
+        /* long matches are hardly improved: skip search inside them */
+        skip = (best_len >= nice_match) ? p + best_len : skip;
+        n += cnt;
+      }
+    }
+    if (p >= obs) {
+      /* inside a skipped long match: same match continues up to its end */
+      int len = (p < skip) ? skip - p : best_len;
+      if (len >= SDEFL_MIN_MATCH) {
+        sdefl_obs_match(&s->split, len);
+        obs = p + len;
+      } else sdefl_obs_lit(&s->split, in[p]);
+    }
+    if (in_len - p > SDEFL_MIN_MATCH) {
+      unsigned h = sdefl_hash32(&in[p], s->hash_bits);
+      s->prv[p & (s->win_siz - 1)] = s->tbl[h];
+      s->tbl[h] = p;
+    }
+    if (s->split.new_obs_cnt >= 512 && p + 1 - blk_begin >= SDEFL_BLK_MIN &&
+        e - (p + 1) >= SDEFL_BLK_MIN && sdefl_split_chk(&s->split, p + 1 - blk_begin)) {
+      e = p + 1;
+    }
+  }
+  o->mat_at[e - blk_begin] = n;
+
+  /* first path: longest match at every position, deferred by a literal if
+   * next position has a longer one (lazy matching of greedy levels), every
+   * parsed path is only kept if cheaper, so block is never worse than it */
+  for (p = blk_begin; p < e; ++p) {
+    unsigned m = sdefl_opt_longest(o, p - blk_begin, e - p);
+    if (m && p + 1 < e && (sdefl_opt_longest(o, p + 1 - blk_begin, e - p - 1) >> 16) > (m >> 16)) {
+      m = 0;
+    }
+    o->path[p - blk_begin] = m;
+  }
+  best = sdefl_opt_costs(o, in, blk_begin, e);
+  memcpy(o->best, o->path, sizeof(unsigned) * (size_t)(e - blk_begin));
+  for (it = 0; it < SDEFL_OPT_ITER; ++it) {
+    sdefl_opt_parse(o, in, blk_begin, e);
+    cost = sdefl_opt_costs(o, in, blk_begin, e);
+    if (cost < best) {
+      best = cost;
+      memcpy(o->best, o->path, sizeof(unsigned) * (size_t)(e - blk_begin));
+    }
+  }
+  /* register final path sequences, short literal runs between short matches
+   * can fill sequences buffer: path registered so far is flushed as a block */
+  p = blk_begin, i = blk_begin;
+  while (p < e) {
+    unsigned choice = o->best[p - blk_begin];
+    if (s->seq_cnt + 3 >= s->seq_siz) {
+      if (litlen) {
+        sdefl_seq(s, p - litlen, litlen);
+        litlen = 0;
+      }
+      sdefl_flush(dst, s, 0, in, i, p);
+      i = p;
+    }
+    if (choice) {
+      int len = (int)(choice >> 16), off = (int)(choice & 0xffff);
+      if (litlen) {
+        sdefl_seq(s, p - litlen, litlen);
+        litlen = 0;
+      }
+      sdefl_seq(s, -off, len);
+      sdefl_reg_match(s, off, len);
+      p += len;
+    } else {
+      s->freq.lit[in[p++]]++;
+      litlen++;
+    }
+  }
+  if (litlen) {
+    sdefl_seq(s, p - litlen, litlen);
+  }
+  SDEFL_FREE(o->cost); SDEFL_FREE(o->path); SDEFL_FREE(o->best);
+  SDEFL_FREE(o->mat); SDEFL_FREE(o->mat_at);
+  SDEFL_FREE(o);
+  sdefl_flush(dst, s, e == in_len, in, i, e);
+  return e;
+}
+static int
+sdefl_blk_lit(unsigned char **dst, struct sdefl *s, const unsigned char *in,
+              int i, int blk_end, int in_len) {
+  /* literals only: whole block is one literal run, stored if not compressible */
+  int blk_begin = i;
+  for (; i < blk_end; ++i) s->freq.lit[in[i]]++;
+  if (blk_end > blk_begin) sdefl_seq(s, blk_begin, blk_end - blk_begin);
+  sdefl_flush(dst, s, blk_end == in_len, in, blk_begin, blk_end);
+  return blk_end;
+}
+static void
+sdefl_probe_upd(struct sdefl_probe *pb, int len, int matched) {
+  /* window of searched bytes with too few bytes matched (noise-like data):
+   * search is skipped on next input, up to a match found on hash chain head */
+  pb->cnt += len, pb->matched += matched;
+  if (pb->cnt < SDEFL_PROBE_LEN) {
+    return;
+  }
+  if (pb->matched * 64 < pb->cnt) {
+    pb->skip = SDEFL_PROBE_SKIP;
+  }
+  pb->cnt = pb->matched = 0;
+}
+static int
+sdefl_blk_rle(unsigned char **dst, struct sdefl *s, const unsigned char *in,
+              int i, int blk_end, int in_len) {
+  /* compress block [i,blk_end) without hash chains: matches are only searched
+   * at distance 1 and strategy distance (RLE), or not searched at all (HUFF) */
+  int dist = (s->strat == SDEFL_STRAT_RLE && s->strat_dist > 1) ? s->strat_dist : 0;
+  int blk_begin = i, litlen = 0;
+  if (s->strat == SDEFL_STRAT_HUFF) {
+    return sdefl_blk_lit(dst, s, in, i, blk_end, in_len);
+  }
+  memset(&s->split, 0, sizeof(s->split));
+  while (i < blk_end) {
+    struct sdefl_match m = {0};
+    int left = blk_end - i;
+    int max_match = (left > SDEFL_MAX_MATCH) ? SDEFL_MAX_MATCH : left;
+    if (s->strat == SDEFL_STRAT_RLE && max_match >= SDEFL_MIN_MATCH) {
+      if (i >= 1 && in[i - 1] == in[i]) {
+        m.len = sdefl_cmp(&in[i - 1], &in[i], 1, max_match), m.off = 1;
+      }
+      if (dist && i >= dist && m.len < max_match && in[i - dist] == in[i]) {
+        int n = sdefl_cmp(&in[i - dist], &in[i], 1, max_match);
+        if (n > m.len) m.len = n, m.off = dist;
+      }
+    }
+    if (m.len >= SDEFL_MIN_MATCH) {
+      if (litlen) {
+        sdefl_seq(s, i - litlen, litlen);
+        litlen = 0;
+      }
+      sdefl_seq(s, -m.off, m.len);
+      sdefl_reg_match(s, m.off, m.len);
+      sdefl_obs_match(&s->split, m.len);
+      i += m.len;
+    } else {
+      s->freq.lit[in[i]]++;
+      sdefl_obs_lit(&s->split, in[i]);
+      litlen++, i++;
+    }
+    if (s->split.new_obs_cnt >= 512 && i - blk_begin >= SDEFL_BLK_MIN &&
+        blk_end - i >= SDEFL_BLK_MIN && sdefl_split_chk(&s->split, i - blk_begin)) {
+      break;
+    }
+    if (s->seq_cnt + 3 >= s->seq_siz) {
+      break; /* short literal runs between short matches */
+    }
+  }
+  if (litlen) {
+    sdefl_seq(s, i - litlen, litlen);
+  }
+  sdefl_flush(dst, s, i == in_len, in, blk_begin, i);
+  return i;
+}
+static int
+sdefl_blk(unsigned char **dst, struct sdefl *s, const unsigned char *in,
+          int i, int blk_end, int in_len, int lvl) {
+  /* compress block [i,blk_end), input up to in_len is available for hashing,
+   * block can end earlier if symbols statistics change, returns block end */
   static const unsigned char pref[] = {8,10,14,24,30,48,65,96,130};
   int max_chain = (lvl < 8) ? (1 << (lvl + 1)): (1 << 13);
-  int n, i = 0, litlen = 0;
-  for (n = 0; n < SDEFL_HASH_SIZ; ++n) {
-    s->tbl[n] = SDEFL_NIL;
+  int blk_begin = i, litlen = 0, skipped = 0;
+  if (s->strat != SDEFL_STRAT_DEF) {
+    return sdefl_blk_rle(dst, s, in, i, blk_end, in_len);
   }
-  do {int blk_begin = i;
-    int blk_end = ((i + SDEFL_BLK_MAX) < in_len) ? (i + SDEFL_BLK_MAX) : in_len;
-    while (i < blk_end) {
-      struct sdefl_match m = {0};
-      int left = blk_end - i;
-      int max_match = (left > SDEFL_MAX_MATCH) ? SDEFL_MAX_MATCH : left;
-      int nice_match = pref[lvl] < max_match ? pref[lvl] : max_match;
-      int run = 1, inc = 1, run_inc = 0;
-      if (max_match > SDEFL_MIN_MATCH) {
-        sdefl_fnd(&m, s, max_chain, max_match, in, i, in_len);
-      }
-      if (lvl >= 5 && m.len >= SDEFL_MIN_MATCH && m.len + 1 < nice_match){
-        struct sdefl_match m2 = {0};
-        sdefl_fnd(&m2, s, max_chain, m.len + 1, in, i + 1, in_len);
-        m.len = (m2.len > m.len) ? 0 : m.len;
+  if (lvl >= SDEFL_LVL_OPT) {
+    return sdefl_blk_opt(dst, s, in, i, blk_end, in_len);
+  }
+  memset(&s->split, 0, sizeof(s->split));
+  while (i < blk_end) {
+    struct sdefl_match m = {0};
+    int left = blk_end - i;
+    int max_match = (left > SDEFL_MAX_MATCH) ? SDEFL_MAX_MATCH : left;
+    int nice_match = pref[lvl] < max_match ? pref[lvl] : max_match;
+    int run = 1, inc = 1, run_inc = 0;
+    int search = !s->probe.skip;
+    if (!search && max_match > SDEFL_MIN_MATCH) {
+      /* skipped search: only chain head is checked, a match resumes search */
+      int c = s->tbl[sdefl_hash32(&in[i], s->hash_bits)];
+      search = (c > SDEFL_NIL && c > i - s->win_siz && sdefl_uload32(&in[c]) == sdefl_uload32(&in[i]));
+      s->probe.skip = search ? 0 : s->probe.skip;
+    }
+    if (search && max_match > SDEFL_MIN_MATCH) {
+      sdefl_fnd(&m, s, max_chain, max_match, in, i, in_len);
+    }
+    if (lvl >= 5 && m.len >= SDEFL_MIN_MATCH && m.len + 1 < nice_match){
+      struct sdefl_match m2 = {0};
+      sdefl_fnd(&m2, s, max_chain, m.len + 1, in, i + 1, in_len);
+      m.len = (m2.len > m.len) ? 0 : m.len;
+    }
+    if (m.len >= SDEFL_MIN_MATCH) {
+      if (litlen) {
+        sdefl_seq(s, i - litlen, litlen);
+        litlen = 0;
       }
-      if (m.len >= SDEFL_MIN_MATCH) {
-        if (litlen) {
-          sdefl_seq(s, i - litlen, litlen);
-          litlen = 0;
-        }
-        sdefl_seq(s, -m.off, m.len);
-        sdefl_reg_match(s, m.off, m.len);
-        if (lvl < 2 && m.len >= nice_match) {
-          inc = m.len;
-        } else {
-          run = m.len;
-        }
+      sdefl_seq(s, -m.off, m.len);
+      sdefl_reg_match(s, m.off, m.len);
+      sdefl_obs_match(&s->split, m.len);
+      if (lvl < 2 && m.len >= nice_match) {
+        inc = m.len;
       } else {
-        s->freq.lit[in[i]]++;
-        litlen++;
+        run = m.len;
       }
-      run_inc = run * inc;
-      if (in_len - (i + run_inc) > SDEFL_MIN_MATCH) {
-        while (run-- > 0) {
-          unsigned h = sdefl_hash32(&in[i]);
-          s->prv[i&SDEFL_WIN_MSK] = s->tbl[h];
-          s->tbl[h] = i, i += inc;
-          assert(i <= blk_end);
-        }
-      } else {
-        i += run_inc;
+    } else {
+      s->freq.lit[in[i]]++;
+      sdefl_obs_lit(&s->split, in[i]);
+      litlen++;
+    }
+    run_inc = run * inc;
+    if (search) {
+      sdefl_probe_upd(&s->probe, run_inc, (m.len >= SDEFL_MIN_MATCH) ? run_inc : 0);
+    } else s->probe.skip--, skipped = 1;
+    if (in_len - (i + run_inc) > SDEFL_MIN_MATCH) {
+      while (run-- > 0) {
+        unsigned h = sdefl_hash32(&in[i], s->hash_bits);
+        s->prv[i & (s->win_siz - 1)] = s->tbl[h];
+        s->tbl[h] = i, i += inc;
         assert(i <= blk_end);
       }
+    } else {
+      i += run_inc;
+      assert(i <= blk_end);
+    }
+    if (s->split.new_obs_cnt >= 512 && i - blk_begin >= SDEFL_BLK_MIN &&
+        blk_end - i >= SDEFL_BLK_MIN && sdefl_split_chk(&s->split, i - blk_begin)) {
+      break;
     }
-    if (litlen) {
-      sdefl_seq(s, i - litlen, litlen);
-      litlen = 0;
+    if (s->seq_cnt + 3 >= s->seq_siz) {
+      break; /* short literal runs between short matches */
     }
-    sdefl_flush(&q, s, blk_end == in_len, in, blk_begin, blk_end);
-  } while (i < in_len);
-  if (s->bitcnt) {
-    sdefl_put(&q, s, 0x00, 8 - s->bitcnt);
   }
-  assert(s->bitcnt == 0);
+  if (litlen) {
+    sdefl_seq(s, i - litlen, litlen);
+    litlen = 0;
+  }
+  s->stats.blk_lit += skipped;
+  sdefl_flush(dst, s, i == in_len, in, blk_begin, i);
+  return i;
+}
+static void
+sdefl_reset(struct sdefl *s) {
+  int n;
+  for (n = 0; n < (1 << s->hash_bits); ++n) {
+    s->tbl[n] = SDEFL_NIL;
+  }
+  memset(&s->probe, 0, sizeof(s->probe));
+}
+static int
+sdefl_compr(struct sdefl *s, unsigned char *out, const unsigned char *in,
+            int in_len, int lvl) {
+  unsigned char *q = out;
+  int i = 0;
+  sdefl_reset(s);
+  do {int blk_end = ((i + s->blk_max) < in_len) ? (i + s->blk_max) : in_len;
+    i = sdefl_blk(&q, s, in, i, blk_end, in_len, lvl);
+  } while (i < in_len);
+  sdefl_put_align(&q, s);
   return (int)(q - out);
 }
 extern int
 sdeflate(struct sdefl *s, void *out, const void *in, int n, int lvl) {
-  s->bits = s->bitcnt = 0;
+  s->bits = 0, s->bitcnt = 0;
+  memset(&s->stats, 0, sizeof(s->stats));
   return sdefl_compr(s, (unsigned char*)out, (const unsigned char*)in, n, lvl);
 }
 static unsigned
@@ -2930,15 +6364,25 @@ sdefl_adler32(unsigned adler32, const unsigned char *in, int in_len) {
   }
   return (unsigned)(s2 << 16) + (unsigned)s1;
 }
+static void
+sdefl_zhdr(unsigned char **dst, struct sdefl *s) {
+  /* deflate with window size of profile, fast compression */
+  unsigned cmf = ((unsigned)(s->win_bits - 8) << 4) | 8u;
+  unsigned flg = 0x01;
+  flg += (31 - ((cmf << 8) + flg) % 31) % 31;
+  sdefl_put(dst, s, cmf, 8);
+  sdefl_put(dst, s, flg, 8);
+  sdefl_put_align(dst, s);
+}
 extern int
 zsdeflate(struct sdefl *s, void *out, const void *in, int n, int lvl) {
   int p = 0;
   unsigned a = 0;
   unsigned char *q = (unsigned char*)out;
 
-  s->bits = s->bitcnt = 0;
-  sdefl_put(&q, s, 0x78, 8); /* deflate, 32k window */
-  sdefl_put(&q, s, 0x01, 8); /* fast compression */
+  s->bits = 0, s->bitcnt = 0;
+  memset(&s->stats, 0, sizeof(s->stats));
+  sdefl_zhdr(&q, s);
   q += sdefl_compr(s, q, (const unsigned char*)in, n, lvl);
 
   /* append adler checksum */
@@ -2947,11 +6391,141 @@ zsdeflate(struct sdefl *s, void *out, const void *in, int n, int lvl) {
     sdefl_put(&q, s, (a >> 24) & 0xFF, 8);
     a <<= 8;
   }
+  sdefl_put_align(&q, s);
   return (int)(q - (unsigned char*)out);
 }
+static int
+sdefl_stream_blk(struct sdefl *s, struct sdefl_stream *z, int blk_end) {
+  unsigned char *q = z->out;
+  int n, d;
+  z->pos = sdefl_blk(&q, s, z->in, z->pos, blk_end, z->len, z->lvl);
+  if (q > z->out && z->write(z->usr, z->out, (int)(q - z->out))) {
+    return -1;
+  }
+  /* slide window: keep last window of input for matches, match positions are
+   * rebased by a multiple of the window size, so chains stay valid */
+  d = (z->pos - s->win_siz) & ~(s->win_siz - 1);
+  if (d > 0) {
+    memmove(z->in, z->in + d, (size_t)(z->len - d));
+    z->pos -= d, z->len -= d;
+    for (n = 0; n < (1 << s->hash_bits); ++n) {
+      s->tbl[n] = (s->tbl[n] >= d) ? (s->tbl[n] - d) : SDEFL_NIL;
+    }
+    for (n = 0; n < s->win_siz; ++n) {
+      s->prv[n] = (s->prv[n] >= d) ? (s->prv[n] - d) : SDEFL_NIL;
+    }
+  }
+  return 0;
+}
+extern int
+zsdeflate_begin(struct sdefl *s, struct sdefl_stream *z, int lvl,
+                sdefl_write_func write, void *usr) {
+  unsigned char *q = 0;
+  z->cap = 2 * s->win_siz + s->blk_max + SDEFL_MIN_MATCH + 1;
+  z->in = (unsigned char*)SDEFL_MALLOC((size_t)z->cap);
+  z->out = (unsigned char*)SDEFL_MALLOC((size_t)s->blk_max + 64);
+  if (!z->in || !z->out) {
+    zsdeflate_free(z);
+    return -1;
+  }
+  q = z->out;
+  z->write = write, z->usr = usr;
+  z->lvl = lvl, z->pos = z->len = 0;
+  z->adler = SDEFL_ADLER_INIT;
+  s->bits = 0, s->bitcnt = 0;
+  memset(&s->stats, 0, sizeof(s->stats));
+  sdefl_reset(s);
+  sdefl_zhdr(&q, s);
+  return z->write(z->usr, z->out, (int)(q - z->out)) ? -1 : 0;
+}
+extern int
+zsdeflate_write(struct sdefl *s, struct sdefl_stream *z, const void *in, int n) {
+  const unsigned char *p = (const unsigned char*)in;
+  z->adler = sdefl_adler32(z->adler, p, n);
+  while (n > 0) {
+    int cnt = z->cap - z->len;
+    cnt = (n < cnt) ? n : cnt;
+    memcpy(z->in + z->len, p, (size_t)cnt);
+    z->len += cnt, p += cnt, n -= cnt;
+    /* full blocks are compressed once some lookahead is available for hashing */
+    while (z->len - z->pos > s->blk_max + SDEFL_MIN_MATCH) {
+      if (sdefl_stream_blk(s, z, z->pos + s->blk_max))
+        return -1;
+    }
+  }
+  return 0;
+}
+extern int
+zsdeflate_end(struct sdefl *s, struct sdefl_stream *z) {
+  unsigned char *q = z->out;
+  unsigned a = z->adler;
+  int p = 0, ret = 0;
+  do {int blk_end = ((z->pos + s->blk_max) < z->len) ? (z->pos + s->blk_max) : z->len;
+    q = z->out;
+    z->pos = sdefl_blk(&q, s, z->in, z->pos, blk_end, z->len, z->lvl);
+    if (z->pos < z->len && z->write(z->usr, z->out, (int)(q - z->out))) {
+      zsdeflate_free(z);
+      return -1;
+    }
+  } while (z->pos < z->len);
+  sdefl_put_align(&q, s);
+  /* append adler checksum */
+  for (p = 0; p < 4; ++p) {
+    sdefl_put(&q, s, (a >> 24) & 0xFF, 8);
+    a <<= 8;
+  }
+  sdefl_put_align(&q, s);
+  ret = z->write(z->usr, z->out, (int)(q - z->out)) ? -1 : 0;
+  zsdeflate_free(z);
+  return ret;
+}
+extern void
+zsdeflate_free(struct sdefl_stream *z) {
+  SDEFL_FREE(z->in);
+  SDEFL_FREE(z->out);
+  z->in = z->out = 0;
+}
+extern struct sdefl*
+sdefl_create(int hash_bits, int win_bits, int blk_max) {
+  struct sdefl *s = 0;
+  size_t siz = 0;
+  hash_bits = (hash_bits <= 0) ? SDEFL_HASH_BITS : hash_bits;
+  hash_bits = (hash_bits < SDEFL_HASH_BITS_MIN) ? SDEFL_HASH_BITS_MIN : hash_bits;
+  hash_bits = (hash_bits > SDEFL_HASH_BITS_MAX) ? SDEFL_HASH_BITS_MAX : hash_bits;
+  win_bits = (win_bits <= 0) ? SDEFL_WIN_BITS : win_bits;
+  win_bits = (win_bits < SDEFL_WIN_BITS_MIN) ? SDEFL_WIN_BITS_MIN : win_bits;
+  win_bits = (win_bits > SDEFL_WIN_BITS) ? SDEFL_WIN_BITS : win_bits;
+  blk_max = (blk_max <= 0) ? SDEFL_BLK_MAX : blk_max;
+  blk_max = (blk_max < SDEFL_BLK_MAX_MIN) ? SDEFL_BLK_MAX_MIN : blk_max;
+  blk_max = (blk_max > SDEFL_BLK_MAX) ? SDEFL_BLK_MAX : blk_max;
+
+  /* single allocation: state followed by hash table, window and sequences */
+  siz = sizeof(struct sdefl);
+  siz += sizeof(int) * ((size_t)1 << hash_bits);
+  siz += sizeof(int) * ((size_t)1 << win_bits);
+  siz += sizeof(struct sdefl_seqt) * (size_t)((blk_max + 2) / 3);
+  s = (struct sdefl*)SDEFL_MALLOC(siz);
+  if (!s) return 0;
+  memset(s, 0, sizeof(*s));
+  s->hash_bits = hash_bits;
+  s->win_bits = win_bits;
+  s->win_siz = 1 << win_bits;
+  s->blk_max = blk_max;
+  s->seq_siz = (blk_max + 2) / 3;
+  s->tbl = (int*)(s + 1);
+  s->prv = s->tbl + (1 << hash_bits);
+  s->seq = (struct sdefl_seqt*)(s->prv + s->win_siz);
+  return s;
+}
+extern void
+sdefl_destroy(struct sdefl *s) {
+  SDEFL_FREE(s);
+}
 extern int
 sdefl_bound(int len) {
-  int max_blocks = 1 + sdefl_div_round_up(len, SDEFL_RAW_BLK_SIZE);
+  /* every compression block can be split into several stored blocks,
+   * blocks of smallest memory profile are cut at least every half block */
+  int max_blocks = 1 + sdefl_div_round_up(len, SDEFL_RAW_BLK_SIZE) + sdefl_div_round_up(len, SDEFL_BLK_MAX_MIN/2);
   int bound = 5 * max_blocks + len + 1 + 4 + 8;
   return bound;
 }
@@ -2982,12 +6556,25 @@ sdefl_bound(int len) {
   #define sinfl_char16_ld(p) _mm_loadu_si128((const __m128i *)(void*)(p))
   #define sinfl_char16_str(d,v)  _mm_storeu_si128((__m128i*)(void*)(d), v)
   #define sinfl_char16_char(c) _mm_set1_epi8(c)
+  #if defined(__SSSE3__) || defined(__AVX__)
+    #include <tmmintrin.h>
+    #define sinfl_char16_shuf(v,m) _mm_shuffle_epi8(v,m)
+  #endif
+  #if defined(__AVX2__)
+    #include <immintrin.h>
+    #define sinfl_char32 __m256i
+    #define sinfl_char32_ld(p) _mm256_loadu_si256((const __m256i *)(void*)(p))
+    #define sinfl_char32_str(d,v) _mm256_storeu_si256((__m256i*)(void*)(d), v)
+  #endif
 #elif defined(__arm__) || defined(__aarch64__)
   #include <arm_neon.h>
   #define sinfl_char16 uint8x16_t
   #define sinfl_char16_ld(p) vld1q_u8((const unsigned char*)(p))
   #define sinfl_char16_str(d,v) vst1q_u8((unsigned char*)(d), v)
   #define sinfl_char16_char(c) vdupq_n_u8(c)
+  #if defined(__aarch64__)
+    #define sinfl_char16_shuf(v,m) vqtbl1q_u8(v,m)
+  #endif
 #else
   #define SINFL_NO_SIMD
 #endif
@@ -3008,6 +6595,7 @@ sinfl_read64(const void *p) {
   memcpy(&n, p, 8);
   return n;
 }
+#ifndef sinfl_char16_shuf
 static void
 sinfl_copy64(unsigned char **dst, unsigned char **src) {
   unsigned long long n;
@@ -3015,11 +6603,53 @@ sinfl_copy64(unsigned char **dst, unsigned char **src) {
   memcpy(*dst, &n, 8);
   *dst += 8, *src += 8;
 }
+#endif
 static unsigned char*
 sinfl_write64(unsigned char *dst, unsigned long long w) {
   memcpy(dst, &w, 8);
   return dst + 8;
 }
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || \
+    defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+#define SINFL_LITTLE_ENDIAN
+#endif
+#if defined(SINFL_LITTLE_ENDIAN) && !defined(sinfl_char16_shuf)
+/* bytes per word store that keep a pattern of offs bytes in phase */
+static const unsigned char sinfl_pat_step8[8] = {0,8,8,6,8,5,6,7};
+static unsigned long long
+sinfl_pattern64(const unsigned char *src, int offs) {
+  /* repeat the first offs (2..7) bytes of src across a word */
+  unsigned long long x = sinfl_read64(src) & ((1ull << (offs << 3)) - 1);
+  unsigned long long w = x;
+  int k;
+  for (k = offs << 3; k < 64; k += offs << 3)
+    w |= x << k;
+  return w;
+}
+#endif
+#ifdef sinfl_char16_shuf
+static const unsigned char sinfl_pat_step16[16] = {
+  0,16,16,15,16,15,12,14,16,9,10,11,12,13,14,15
+};
+static const unsigned char sinfl_pat_idx[16][16] = {
+  {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+  {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},
+  {0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1},
+  {0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0},
+  {0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3},
+  {0,1,2,3,4,0,1,2,3,4,0,1,2,3,4,0},
+  {0,1,2,3,4,5,0,1,2,3,4,5,0,1,2,3},
+  {0,1,2,3,4,5,6,0,1,2,3,4,5,6,0,1},
+  {0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7},
+  {0,1,2,3,4,5,6,7,8,0,1,2,3,4,5,6},
+  {0,1,2,3,4,5,6,7,8,9,0,1,2,3,4,5},
+  {0,1,2,3,4,5,6,7,8,9,10,0,1,2,3,4},
+  {0,1,2,3,4,5,6,7,8,9,10,11,0,1,2,3},
+  {0,1,2,3,4,5,6,7,8,9,10,11,12,0,1,2},
+  {0,1,2,3,4,5,6,7,8,9,10,11,12,13,0,1},
+  {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,0},
+};
+#endif
 #ifndef SINFL_NO_SIMD
 static unsigned char*
 sinfl_write128(unsigned char *dst, sinfl_char16 w) {
@@ -3033,12 +6663,37 @@ sinfl_copy128(unsigned char **dst, unsigned char **src) {
   *dst += 16, *src += 16;
 }
 #endif
+#ifdef sinfl_char32
 static void
-sinfl_refill(struct sinfl *s) {
+sinfl_copy256(unsigned char **dst, unsigned char **src) {
+  sinfl_char32 n = sinfl_char32_ld(*src);
+  sinfl_char32_str(*dst, n);
+  *dst += 32, *src += 32;
+}
+#endif
+static void
+sinfl_refill_fast(struct sinfl *s) {
+  /* unchecked refill: caller ensures a whole word is left in input */
+  assert(s->bitend - s->bitptr >= 8);
   s->bitbuf |= sinfl_read64(s->bitptr) << s->bitcnt;
   s->bitptr += (63 - s->bitcnt) >> 3;
   s->bitcnt |= 56; /* bitcount in range [56,63] */
 }
+static void
+sinfl_refill_tail(struct sinfl *s) {
+  /* careful refill: bytes up to input end, zeros past it */
+  for (; s->bitcnt < 56; s->bitcnt += 8) {
+    if (s->bitptr < s->bitend)
+      s->bitbuf |= (unsigned long long)*s->bitptr++ << s->bitcnt;
+    else s->bitover++;
+  }
+}
+static void
+sinfl_refill(struct sinfl *s) {
+  if (sinfl_likely(s->bitend - s->bitptr >= 8))
+    sinfl_refill_fast(s);
+  else sinfl_refill_tail(s);
+}
 static int
 sinfl_peek(struct sinfl *s, int cnt) {
   assert(cnt >= 0 && cnt <= 56);
@@ -3175,22 +6830,64 @@ sinfl_build(unsigned *tbl, unsigned char *lens, int tbl_bits, int maxlen,
     sinfl_build_subtbl(&gen, tbl, tbl_bits, cnt);
   }
 }
-static int
-sinfl_decode(struct sinfl *s, const unsigned *tbl, int bit_len) {
-  int idx = sinfl_peek(s, bit_len);
-  unsigned key = tbl[idx];
+static void
+sinfl_pack_lits(unsigned *tbl, int tbl_bits) {
+  /* literal entries are flagged 0x20 with code length in bits 8-11, root
+   * entries of short literal codes also hold the next literal (flag 0x40) if
+   * remaining index bits fully decode it, low 4 bits are both codes length.
+   * Root entries are packed from the end: next code entry is still unpacked */
+  int i, n;
+  for (i = (1 << tbl_bits) - 1; i >= 0; --i) {
+    unsigned key = tbl[i], nxt, len = key & 0x0f;
+    if (key & 0x10) {
+      /* sub-table: literal entries are only flagged */
+      unsigned *sub = tbl + ((key >> 16) & 0xffff);
+      for (n = 0; n < (1 << len); ++n) {
+        if ((sub[n] >> 16) < 256)
+          sub[n] |= ((sub[n] & 0x0f) << 8) | 0x20;
+      }
+      continue;
+    }
+    if ((key >> 16) >= 256) continue;
+    nxt = tbl[i >> len];
+    if (len < (unsigned)tbl_bits && !(nxt & 0x10) && (nxt >> 16) < 256 &&
+        len + (nxt & 0x0f) <= (unsigned)tbl_bits) {
+      tbl[i] = ((nxt >> 16) << 24) | (key & 0x00ff0000) | (len << 8) | 0x60 | (len + (nxt & 0x0f));
+    } else tbl[i] = key | (len << 8) | 0x20;
+  }
+}
+static unsigned
+sinfl_lookup(struct sinfl *s, const unsigned *tbl, int bit_len) {
+  /* table entry of next code, sub-table index bits are eaten if required */
+  unsigned key = tbl[sinfl_peek(s, bit_len)];
   if (key & 0x10) {
     /* sub-table lookup */
     int len = key & 0x0f;
     sinfl_eat(s, bit_len);
-    idx = sinfl_peek(s, len);
-    key = tbl[((key >> 16) & 0xffff) + (unsigned)idx];
+    key = tbl[((key >> 16) & 0xffff) + (unsigned)sinfl_peek(s, len)];
+  }
+  return key;
+}
+static int
+sinfl_decode(struct sinfl *s, const unsigned *tbl, int bit_len) {
+  unsigned key = sinfl_lookup(s, tbl, bit_len);
+  if (key & 0x20) {
+    /* packed literals: first one only */
+    sinfl_eat(s, (key >> 8) & 0x0f);
+    return (key >> 16) & 0xff;
   }
   sinfl_eat(s, key & 0x0f);
   return (key >> 16) & 0x0fff;
 }
+static unsigned char*
+sinfl_slide(unsigned char *base, unsigned char *out) {
+  /* keep last window of decompressed data for matches */
+  memmove(base, out - SINFL_WIN_SIZ, SINFL_WIN_SIZ);
+  return base + SINFL_WIN_SIZ;
+}
 static int
-sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size) {
+sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size,
+                 sinfl_write_func write, void *usr) {
   static const unsigned char order[] = {16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15};
   static const short dbase[30+2] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,
       257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
@@ -3203,22 +6900,34 @@ sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size)
 
   const unsigned char *oe = out + cap;
   const unsigned char *e = in + size, *o = out;
+  /* streaming: flush to callback before remaining space can not hold a match */
+  const unsigned char *fe = write ? oe - (258 + 64) : oe;
+  /* fast path limits: four literals and a match (simd copies overrun) fit,
+   * two unchecked refills of 8 bytes fit */
+  const unsigned char *fo = (cap > 258 + 64) ? oe - (258 + 64) : out;
+  const unsigned char *fi = (size > 16) ? e - 16 : in;
+  unsigned char *base = out, *f = out;
   enum sinfl_states {hdr,stored,fixed,dyn,blk};
   enum sinfl_states state = hdr;
   struct sinfl s = {0};
-  int last = 0;
+  int last = 0, done = 0;
 
   s.bitptr = in;
+  s.bitend = e;
   while (1) {
     switch (state) {
     case hdr: {
       /* block header */
       int type = 0;
       sinfl_refill(&s);
+      if (s.bitover > 7) {
+        /* more zero bytes than bits buffer holds: input end was consumed */
+        goto fin;
+      }
       last = sinfl__get(&s,1);
       type = sinfl__get(&s,2);
 
-      switch (type) {default: return (int)(out-o);
+      switch (type) {default: goto fin;
       case 0x00: state = stored; break;
       case 0x01: state = fixed; break;
       case 0x02: state = dyn; break;}
@@ -3229,17 +6938,28 @@ sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size)
       sinfl__get(&s,s.bitcnt & 7);
       len = (unsigned short)sinfl__get(&s,16);
       nlen = (unsigned short)sinfl__get(&s,16);
-      s.bitptr -= s.bitcnt / 8;
-      s.bitbuf = s.bitcnt = 0;
+      if (s.bitover > s.bitcnt / 8)
+        goto fin;
+      s.bitptr -= s.bitcnt / 8 - s.bitover;
+      s.bitbuf = s.bitcnt = s.bitover = 0;
 
       if ((unsigned short)len != (unsigned short)~nlen)
-        return (int)(out-o);
-      if (len > (e - s.bitptr) || !len)
-        return (int)(out-o);
-
-      memcpy(out, s.bitptr, (size_t)len);
-      s.bitptr += len, out += len;
-      if (last) return (int)(out-o);
+        goto fin;
+      if (len > (e - s.bitptr))
+        goto fin;
+
+      while (len) {
+        unsigned n;
+        if (write && out >= fe) {
+          if (write(usr, f, (int)(out - f))) return -1;
+          f = out = sinfl_slide(base, out);
+        }
+        n = (unsigned)(oe - out) < len ? (unsigned)(oe - out) : len;
+        if (!n) goto fin;
+        memcpy(out, s.bitptr, (size_t)n);
+        s.bitptr += n, out += n, len -= n;
+      }
+      if (last) {done = 1; goto fin;}
       state = hdr;
     } break;
     case fixed: {
@@ -3252,8 +6972,9 @@ sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size)
       for (n = 0; n < 32; n++) lens[288+n] = 5;
 
       /* build lit/dist tables */
-      sinfl_build(s.lits, lens, 10, 15, 288);
+      sinfl_build(s.lits, lens, SINFL_LIT_TBL_BITS, 15, 288);
       sinfl_build(s.dsts, lens + 288, 8, 15, 32);
+      sinfl_pack_lits(s.lits, SINFL_LIT_TBL_BITS);
       state = blk;
     } break;
     case dyn: {
@@ -3272,72 +6993,117 @@ sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size)
 
       /* decode code lengths */
       for (n = 0; n < nlit + ndist;) {
-        int sym = 0;
+        int sym = 0, c = 0;
         sinfl_refill(&s);
         sym = sinfl_decode(&s, hlens, 7);
-        switch (sym) {default: lens[n++] = (unsigned char)sym; break;
-        case 16: for (i=3+sinfl_get(&s,2);i;i--,n++) lens[n]=lens[n-1]; break;
-        case 17: for (i=3+sinfl_get(&s,3);i;i--,n++) lens[n]=0; break;
-        case 18: for (i=11+sinfl_get(&s,7);i;i--,n++) lens[n]=0; break;}
+        switch (sym) {default: lens[n++] = (unsigned char)sym; continue;
+        case 16: if (!n) goto fin; c = lens[n-1]; i = 3+sinfl_get(&s,2); break;
+        case 17: i = 3+sinfl_get(&s,3); break;
+        case 18: i = 11+sinfl_get(&s,7); break;}
+        /* repeated lengths must not run past the last code */
+        if (i > nlit + ndist - n) goto fin;
+        memset(lens + n, c, (size_t)i);
+        n += i;
       }
       /* build lit/dist tables */
-      sinfl_build(s.lits, lens, 10, 15, nlit);
+      sinfl_build(s.lits, lens, SINFL_LIT_TBL_BITS, 15, nlit);
       sinfl_build(s.dsts, lens + nlit, 8, 15, ndist);
+      sinfl_pack_lits(s.lits, SINFL_LIT_TBL_BITS);
       state = blk;}
     } break;
     case blk: {
       /* decompress block */
       while (1) {
         int sym;
-        sinfl_refill(&s);
-        sym = sinfl_decode(&s, s.lits, 10);
-        if (sym < 256) {
-          /* literal */
-          if (sinfl_unlikely(out >= oe)) {
-            return (int)(out-o);
+        if (write && out >= fe) {
+          if (write(usr, f, (int)(out - f))) return -1;
+          f = out = sinfl_slide(base, out);
+        }
+        if (sinfl_likely(out < fo && s.bitptr < fi)) {
+          unsigned key;
+          sinfl_refill_fast(&s);
+          /* fast path: up to six literals per refill (three codes of at
+           * most 15 bits), output and input can hold literals and a match
+           * without bounds checks, literal pairs are written as words */
+          key = sinfl_lookup(&s, s.lits, SINFL_LIT_TBL_BITS);
+          if (key & 0x20) {
+            out[0] = (unsigned char)(key >> 16);
+            out[1] = (unsigned char)(key >> 24);
+            out += 1 + ((key >> 6) & 1);
+            sinfl_eat(&s, key & 0x0f);
+            key = sinfl_lookup(&s, s.lits, SINFL_LIT_TBL_BITS);
+            if (key & 0x20) {
+              out[0] = (unsigned char)(key >> 16);
+              out[1] = (unsigned char)(key >> 24);
+              out += 1 + ((key >> 6) & 1);
+              sinfl_eat(&s, key & 0x0f);
+              key = sinfl_lookup(&s, s.lits, SINFL_LIT_TBL_BITS);
+              if (key & 0x20) {
+                out[0] = (unsigned char)(key >> 16);
+                out[1] = (unsigned char)(key >> 24);
+                out += 1 + ((key >> 6) & 1);
+                sinfl_eat(&s, key & 0x0f);
+                continue;
+              }
+            }
+            /* match bits: up to 48 bits after code table index */
+            sinfl_refill_fast(&s);
+          }
+          sinfl_eat(&s, key & 0x0f);
+          sym = (int)(key >> 16) & 0x0fff;
+        } else {
+          /* careful path: one literal at a time, output bounds checked */
+          sinfl_refill(&s);
+          if (sinfl_unlikely(s.bitover > 7)) {
+            goto fin;
           }
-          *out++ = (unsigned char)sym;
-          sym = sinfl_decode(&s, s.lits, 10);
+          sym = sinfl_decode(&s, s.lits, SINFL_LIT_TBL_BITS);
           if (sym < 256) {
+            if (sinfl_unlikely(out >= oe)) {
+              goto fin;
+            }
             *out++ = (unsigned char)sym;
             continue;
           }
         }
         if (sinfl_unlikely(sym == 256)) {
           /* end of block */
-          if (last) return (int)(out-o);
+          if (last) {done = 1; goto fin;}
           state = hdr;
           break;
         }
         /* match */
         if (sym >= 286) {
           /* length codes 286 and 287 must not appear in compressed data */
-          return (int)(out-o);
+          goto fin;
         }
         sym -= 257;
         {int len = sinfl__get(&s, lbits[sym]) + lbase[sym];
         int dsym = sinfl_decode(&s, s.dsts, 8);
         int offs = sinfl__get(&s, dbits[dsym]) + dbase[dsym];
         unsigned char *dst = out, *src = out - offs;
-        if (sinfl_unlikely(offs > (int)(out-o))) {
-          return (int)(out-o);
+        /* distance codes 30 and 31 must not appear: offset would be zero */
+        if (sinfl_unlikely(!offs || offs > (int)(out-o) || len > (int)(oe-out))) {
+          goto fin;
         }
         out = out + len;
 
 #ifndef SINFL_NO_SIMD
         if (sinfl_likely(oe - out >= 16 * 3)) {
+#ifdef sinfl_char32
+          if (offs >= 32) {
+            /* wide simd copy match */
+            sinfl_copy256(&dst, &src);
+            do sinfl_copy256(&dst, &src);
+            while (dst < out);
+          } else
+#endif
           if (offs >= 16) {
             /* simd copy match */
             sinfl_copy128(&dst, &src);
             sinfl_copy128(&dst, &src);
             do sinfl_copy128(&dst, &src);
             while (dst < out);
-          } else if (offs >= 8) {
-            /* word copy match */
-            sinfl_copy64(&dst, &src);
-            sinfl_copy64(&dst, &src);
-            do sinfl_copy64(&dst, &src);
-            while (dst < out);
           } else if (offs == 1) {
             /* rle match copying */
             sinfl_char16 w = sinfl_char16_char(src[0]);
@@ -3346,11 +7112,37 @@ sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size)
             do dst = sinfl_write128(dst, w);
             while (dst < out);
           } else {
-            /* byte copy match */
-            *dst++ = *src++;
-            *dst++ = *src++;
-            do *dst++ = *src++;
+#ifdef sinfl_char16_shuf
+            /* pattern match: shuffle the first offs bytes across a vector
+             * and store it in steps that are a multiple of offs */
+            sinfl_char16 m = sinfl_char16_ld(sinfl_pat_idx[offs]);
+            sinfl_char16 w = sinfl_char16_shuf(sinfl_char16_ld(src), m);
+            int step = sinfl_pat_step16[offs];
+            do {sinfl_char16_str(dst, w); dst += step;}
             while (dst < out);
+#else
+            if (offs >= 8) {
+              /* word copy match */
+              sinfl_copy64(&dst, &src);
+              sinfl_copy64(&dst, &src);
+              do sinfl_copy64(&dst, &src);
+              while (dst < out);
+            } else {
+#ifdef SINFL_LITTLE_ENDIAN
+              /* pattern match: replicate the first offs bytes in a word */
+              unsigned long long w = sinfl_pattern64(src, offs);
+              int step = sinfl_pat_step8[offs];
+              do {sinfl_write64(dst, w); dst += step;}
+              while (dst < out);
+#else
+              /* byte copy match */
+              *dst++ = *src++;
+              *dst++ = *src++;
+              do *dst++ = *src++;
+              while (dst < out);
+#endif
+            }
+#endif
           }
         }
 #else
@@ -3371,11 +7163,19 @@ sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size)
             do dst = sinfl_write64(dst, w);
             while (dst < out);
           } else {
+#ifdef SINFL_LITTLE_ENDIAN
+            /* pattern match: replicate the first offs bytes in a word */
+            unsigned long long w = sinfl_pattern64(src, offs);
+            int step = sinfl_pat_step8[offs];
+            do {sinfl_write64(dst, w); dst += step;}
+            while (dst < out);
+#else
             /* byte copy match */
             *dst++ = *src++;
             *dst++ = *src++;
             do *dst++ = *src++;
             while (dst < out);
+#endif
           }
         }
 #endif
@@ -3388,11 +7188,22 @@ sinfl_decompress(unsigned char *out, int cap, const unsigned char *in, int size)
       }
     } break;}
   }
+fin:
+  if (write) {
+    if (out > f && write(usr, f, (int)(out - f))) return -1;
+    return done ? 0 : -1;
+  }
   return (int)(out-o);
 }
 extern int
 sinflate(void *out, int cap, const void *in, int size) {
-  return sinfl_decompress((unsigned char*)out, cap, (const unsigned char*)in, size);
+  return sinfl_decompress((unsigned char*)out, cap, (const unsigned char*)in, size, 0, 0);
+}
+extern int
+sinflate_stream(void *buf, int cap, const void *in, int size,
+                sinfl_write_func write, void *usr) {
+  if (cap < 2*SINFL_WIN_SIZ) return -1;
+  return sinfl_decompress((unsigned char*)buf, cap, (const unsigned char*)in, size, write, usr);
 }
 static unsigned
 sinfl_adler32(unsigned adler32, const unsigned char *in, int in_len) {
@@ -3426,14 +7237,43 @@ zsinflate(void *out, int cap, const void *mem, int size) {
   const unsigned char *in = (const unsigned char*)mem;
   if (size >= 6) {
     const unsigned char *eob = in + size - 4;
-    int n = sinfl_decompress((unsigned char*)out, cap, in + 2u, size);
+    int n = sinfl_decompress((unsigned char*)out, cap, in + 2u, size - 2, 0, 0);
     unsigned a = sinfl_adler32(1u, (unsigned char*)out, n);
-    unsigned h = eob[0] << 24 | eob[1] << 16 | eob[2] << 8 | eob[3] << 0;
+    unsigned h = (unsigned)eob[0] << 24 | eob[1] << 16 | eob[2] << 8 | eob[3] << 0;
     return a == h ? n : -1;
   } else {
     return -1;
   }
 }
+struct sinfl_zstream {
+  sinfl_write_func write;
+  void *usr;
+  unsigned adler;
+};
+static int
+sinfl_zwrite(void *usr, const unsigned char *data, int len) {
+  struct sinfl_zstream *z = (struct sinfl_zstream*)usr;
+  z->adler = sinfl_adler32(z->adler, data, len);
+  return z->write(z->usr, data, len);
+}
+extern int
+zsinflate_stream(void *buf, int cap, const void *mem, int size,
+                 sinfl_write_func write, void *usr) {
+  const unsigned char *in = (const unsigned char*)mem;
+  struct sinfl_zstream z;
+  const unsigned char *eob;
+  unsigned h;
+  if (size < 6 || cap < 2*SINFL_WIN_SIZ) return -1;
+  /* zlib header: deflate method, valid check bits, no preset dictionary */
+  if ((in[0] & 0x0f) != 8 || ((in[0] << 8) | in[1]) % 31 || (in[1] & 0x20))
+    return -1;
+  z.write = write, z.usr = usr, z.adler = 1u;
+  if (sinfl_decompress((unsigned char*)buf, cap, in + 2u, size - 2, sinfl_zwrite, &z))
+    return -1;
+  eob = in + size - 4;
+  h = (unsigned)eob[0] << 24 | eob[1] << 16 | eob[2] << 8 | eob[3] << 0;
+  return z.adler == h ? 0 : -1;
+}
 
 #endif  /* SINFL_IMPLEMENTATION */
 